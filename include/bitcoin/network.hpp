@@ -16,27 +16,51 @@
 
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/acceptor.hpp>
+#include <bitcoin/network/address_gossip.hpp>
+#include <bitcoin/network/block_parser.hpp>
+#include <bitcoin/network/block_scheduler.hpp>
+#include <bitcoin/network/block_source.hpp>
+#include <bitcoin/network/bloom_filter.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/compact_block_relay.hpp>
+#include <bitcoin/network/connect_scheduler.hpp>
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/hosts.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
 #include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/pin_sketch.hpp>
 #include <bitcoin/network/proxy.hpp>
+#include <bitcoin/network/reconciliation_set.hpp>
+#include <bitcoin/network/rolling_bloom_filter.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/sip_hash.hpp>
+#include <bitcoin/network/transaction_scheduler.hpp>
+#include <bitcoin/network/transaction_source.hpp>
+#include <bitcoin/network/upload_shaper.hpp>
 #include <bitcoin/network/version.hpp>
+#include <bitcoin/network/wire_payload.hpp>
 #include <bitcoin/network/protocols/protocol.hpp>
 #include <bitcoin/network/protocols/protocol_address_31402.hpp>
+#include <bitcoin/network/protocols/protocol_block_download_31402.hpp>
+#include <bitcoin/network/protocols/protocol_bloom_filter_70001.hpp>
+#include <bitcoin/network/protocols/protocol_compact_block_70014.hpp>
 #include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/protocols/protocol_fee_filter_70013.hpp>
+#include <bitcoin/network/protocols/protocol_inventory_31402.hpp>
 #include <bitcoin/network/protocols/protocol_ping_31402.hpp>
 #include <bitcoin/network/protocols/protocol_ping_60001.hpp>
+#include <bitcoin/network/protocols/protocol_reconciliation_70014.hpp>
 #include <bitcoin/network/protocols/protocol_reject_70002.hpp>
 #include <bitcoin/network/protocols/protocol_seed_31402.hpp>
+#include <bitcoin/network/protocols/protocol_send_headers_70012.hpp>
 #include <bitcoin/network/protocols/protocol_timer.hpp>
+#include <bitcoin/network/protocols/protocol_transaction_download_31402.hpp>
 #include <bitcoin/network/protocols/protocol_version_31402.hpp>
 #include <bitcoin/network/protocols/protocol_version_70002.hpp>
 #include <bitcoin/network/sessions/session.hpp>
 #include <bitcoin/network/sessions/session_batch.hpp>
+#include <bitcoin/network/sessions/session_block_relay.hpp>
 #include <bitcoin/network/sessions/session_inbound.hpp>
 #include <bitcoin/network/sessions/session_manual.hpp>
 #include <bitcoin/network/sessions/session_outbound.hpp>
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_ADDRESS_GOSSIP_HPP
+#define LIBBITCOIN_NETWORK_ADDRESS_GOSSIP_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/hosts.hpp>
+#include <bitcoin/network/rolling_bloom_filter.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Queues gossiped addresses for storage in the host pool, thread safe.
+/// The queue is drained on the thread pool in small batches, so that the
+/// host pool lock is held for a bounded time however fast addresses arrive.
+/// Also selects the fresh addresses that have not been recently relayed, and
+/// caches a random sample of the host pool with which to answer get_address.
+class BCT_API address_gossip
+  : public enable_shared_from_base<address_gossip>, noncopyable
+{
+public:
+    typedef std::shared_ptr<address_gossip> ptr;
+    typedef message::network_address address;
+
+    /// Construct an instance.
+    address_gossip(threadpool& pool, hosts& hosts);
+
+    /// Accept addresses for storage.
+    virtual void start();
+
+    /// Discard queued addresses and stop accepting more.
+    virtual void stop();
+
+    /// Queue addresses for storage, those in excess of the queue limit are
+    /// dropped.
+    virtual void store(const address::list& addresses);
+
+    /// Select the valid and recently-timestamped addresses not previously
+    /// selected within the retention of the relay filter.
+    virtual address::list relayable(const address::list& addresses);
+
+    /// The number of addresses awaiting storage.
+    virtual size_t queued() const;
+
+    /// A random sample of the host pool, refreshed once per sample window.
+    virtual address_const_ptr sample();
+
+private:
+    void drain();
+    void handle_store(const code& ec);
+
+    // These are thread safe.
+    std::atomic<bool> stopped_;
+    hosts& hosts_;
+    dispatcher dispatch_;
+
+    // These are protected by mutex.
+    bool draining_;
+    std::deque<address> queue_;
+    rolling_bloom_filter relayed_;
+    address_const_ptr sample_;
+    asio::time_point expiry_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BLOCK_PARSER_HPP
+#define LIBBITCOIN_NETWORK_BLOCK_PARSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Incremental parser for a block payload arriving in pieces.
+/// Each transaction is parsed as soon as its last byte is written, so only
+/// the unparsed tail of the payload is buffered. The length of a partial
+/// transaction is measured as bytes arrive and the transaction is parsed
+/// once, so the cost of parsing is linear in the payload size. This class
+/// is not thread safe, it is driven by the read cycle of a single proxy.
+class BCT_API block_parser
+  : noncopyable
+{
+public:
+    typedef std::shared_ptr<block_parser> ptr;
+    typedef std::function<void(header_const_ptr, size_t,
+        transaction_const_ptr)> transaction_handler;
+
+    /// Construct an instance for a payload of the given size.
+    /// The handler (optional) is invoked for each transaction upon parse.
+    block_parser(size_t payload_size, transaction_handler handler);
+
+    /// Parse as much of the payload as possible after appending the data.
+    /// Returns error::bad_stream if the payload is invalid.
+    code write(const data_chunk& data);
+
+    /// The number of payload bytes not yet written.
+    size_t remaining() const;
+
+    /// All bytes have been written and the block has been fully parsed.
+    bool complete() const;
+
+    /// Move the parsed block out of the parser, call once when complete.
+    block_const_ptr finish();
+
+private:
+    enum class state
+    {
+        header,
+        count,
+        transactions,
+        done,
+        invalid
+    };
+
+    // The transaction field at which measurement resumes.
+    enum class field
+    {
+        version,
+        marker,
+        input_count,
+        input_point,
+        input_script_size,
+        input_script,
+        input_sequence,
+        output_count,
+        output_value,
+        output_script_size,
+        output_script,
+        witness_count,
+        witness_size,
+        witness,
+        locktime
+    };
+
+    size_t available() const;
+    bool skip(uint64_t size);
+    bool read_size(uint64_t& value);
+    bool measure();
+    void compact();
+
+    bool parse_header();
+    bool parse_count();
+    bool parse_transactions();
+
+    const size_t payload_size_;
+    const transaction_handler handler_;
+
+    state state_;
+    size_t written_;
+    uint64_t count_;
+    chain::header header_;
+    header_const_ptr header_ptr_;
+    chain::transaction::list transactions_;
+
+    // Unparsed bytes begin at offset_, bytes before it await compaction.
+    data_chunk buffer_;
+    size_t offset_;
+
+    // Measurement of the transaction at offset_, resumed on each write.
+    field field_;
+    size_t measured_;
+    uint64_t length_;
+    uint64_t inputs_;
+    uint64_t remaining_;
+    uint64_t items_;
+    bool witness_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BLOCK_SCHEDULER_HPP
+#define LIBBITCOIN_NETWORK_BLOCK_SCHEDULER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Schedules block downloads across channels, thread safe.
+/// Blocks are enqueued in download order and requested only within a window
+/// that advances as the earliest outstanding blocks are received. Blocks are
+/// assigned to the peers of highest measured throughput that have capacity.
+/// A peer that times out, or that stalls the window by holding its earliest
+/// block, is stopped and its blocks are assigned to other peers. A block
+/// that all peers report not found is retried after the request timeout.
+class BCT_API block_scheduler
+  : public enable_shared_from_base<block_scheduler>, noncopyable
+{
+public:
+    typedef std::shared_ptr<block_scheduler> ptr;
+    typedef std::function<void(const code&)> result_handler;
+    typedef std::function<void(const hash_list&)> request_handler;
+
+    /// Construct an instance.
+    block_scheduler(threadpool& pool, const settings& settings);
+
+    /// Start the stall detection timer.
+    virtual void start();
+
+    /// Stop the stall detection timer and clear all state.
+    virtual void stop();
+
+    /// Enqueue blocks for download, in the order they are to be downloaded.
+    virtual void enqueue(const hash_list& hashes);
+
+    /// Register a peer, with the handlers by which to request from and stop it.
+    virtual void connect(uint64_t peer, request_handler request,
+        result_handler stop);
+
+    /// Unregister a peer, assigning its in-flight blocks elsewhere.
+    virtual void disconnect(uint64_t peer);
+
+    /// The peer delivered the block, of the given serialized size.
+    virtual void received(uint64_t peer, const hash_digest& hash,
+        size_t size);
+
+    /// The peer does not have the blocks.
+    virtual void not_found(uint64_t peer, const hash_list& hashes);
+
+    /// The number of blocks requested from the peer and outstanding.
+    virtual size_t in_flight(uint64_t peer) const;
+
+    /// The measured download rate of the peer, in bytes per second.
+    virtual double throughput(uint64_t peer) const;
+
+    /// The number of enqueued blocks not yet received.
+    virtual size_t pending() const;
+
+private:
+    typedef std::map<uint64_t, hash_list> requests;
+    typedef std::map<uint64_t, result_handler> stops;
+
+    struct entry
+    {
+        uint64_t requested;
+        asio::time_point time;
+        bool received;
+        std::set<uint64_t> excluded;
+    };
+
+    struct peer
+    {
+        request_handler request;
+        result_handler stop;
+        size_t in_flight;
+        double rate;
+        asio::time_point last;
+    };
+
+    void release(entry& item);
+    void remove(uint64_t peer, stops& out);
+    void readmit(const asio::time_point& now);
+    void advance();
+    void schedule(requests& out);
+    void send(const requests& out) const;
+
+    void start_timer();
+    void handle_timer(const code& ec);
+
+    // These are thread safe.
+    std::atomic<bool> stopped_;
+    const size_t window_;
+    const size_t limit_;
+    const asio::duration timeout_;
+    const asio::duration stall_;
+    const deadline::ptr timer_;
+
+    // These are protected by mutex.
+    size_t outstanding_;
+    std::deque<hash_digest> order_;
+    std::map<hash_digest, entry> entries_;
+    std::map<uint64_t, peer> peers_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
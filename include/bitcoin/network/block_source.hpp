@@ -0,0 +1,46 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BLOCK_SOURCE_HPP
+#define LIBBITCOIN_NETWORK_BLOCK_SOURCE_HPP
+
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Interface to stored blocks (such as a block chain), for serving block
+/// derived messages to peers. Implement this in the node and set it on the
+/// network (see p2p).
+class BCT_API block_source
+{
+public:
+    typedef std::shared_ptr<block_source> ptr;
+
+    virtual ~block_source() {}
+
+    /// Get the block of the given hash, or null if not found, thread safe.
+    virtual block_const_ptr fetch(const hash_digest& hash) const = 0;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
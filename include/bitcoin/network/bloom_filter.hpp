@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_BLOOM_FILTER_HPP
+#define LIBBITCOIN_NETWORK_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A peer transaction filter (bip37), thread safe.
+/// Transaction matching is limited to a budget of time per second, beyond
+/// which transactions do not match, bounding the processing cost of a peer.
+class BCT_API bloom_filter
+{
+public:
+    typedef std::shared_ptr<bloom_filter> ptr;
+
+    /// Outputs that match insert their outpoint into the filter.
+    enum class update : uint8_t
+    {
+        none = 0,
+        all = 1,
+        pay_key_only = 2
+    };
+
+    /// Limits on the filter and on elements added to it.
+    static const size_t maximum_filter_size;
+    static const size_t maximum_hash_functions;
+    static const size_t maximum_element_size;
+
+    /// Determine if the filter is within limits.
+    static bool valid(const message::filter_load& message);
+
+    /// Construct from a valid filter with a time budget per second.
+    bloom_filter(const message::filter_load& message,
+        const asio::duration& budget);
+
+    /// Insert an element into the filter.
+    void insert(data_slice element);
+
+    /// Determine if the element is (probably) in the filter.
+    bool contains(data_slice element) const;
+
+    /// Determine if the transaction matches the filter, updating the filter
+    /// as configured. False if the time budget is exhausted.
+    bool matches(const chain::transaction& tx);
+
+    /// Determine which transactions of the block match the filter, updating
+    /// the filter as configured. False if the time budget is exhausted.
+    bool matches(const chain::block& block, std::vector<bool>& out);
+
+private:
+    void refresh();
+    bool match(const chain::transaction& tx);
+    void do_insert(data_slice element);
+    bool do_contains(data_slice element) const;
+
+    const uint32_t tweak_;
+    const update update_;
+    const asio::duration budget_;
+
+    // These are protected by mutex.
+    data_chunk bits_;
+    size_t functions_;
+    bool empty_;
+    bool full_;
+    asio::time_point window_;
+    asio::duration spent_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
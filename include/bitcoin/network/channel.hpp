@@ -22,13 +22,16 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <utility>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/bloom_filter.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
 #include <bitcoin/network/proxy.hpp>
+#include <bitcoin/network/reconciliation_set.hpp>
 #include <bitcoin/network/settings.hpp>
 
 namespace libbitcoin {
@@ -40,12 +43,46 @@ class BCT_API channel
 {
 public:
     typedef std::shared_ptr<channel> ptr;
+    typedef std::function<bool(const code&, inventory_const_ptr, uint64_t)>
+        announce_handler;
+    typedef resubscriber<code, inventory_const_ptr, uint64_t>
+        announce_subscriber;
+    typedef std::function<bool(const code&, headers_const_ptr)>
+        headers_handler;
+    typedef resubscriber<code, headers_const_ptr> headers_subscriber;
+    typedef std::function<bool(const code&, transaction_const_ptr, uint64_t)>
+        transaction_handler;
+    typedef resubscriber<code, transaction_const_ptr, uint64_t>
+        transaction_subscriber;
 
     /// Construct an instance.
     channel(threadpool& pool, socket::ptr socket, const settings& settings);
 
     void start(result_handler handler) override;
 
+    // Announcements (see p2p::announce).
+    // Subscriptions are released when the channel stops.
+
+    /// Subscribe to inventory announcement requests.
+    virtual void subscribe_announcement(announce_handler handler);
+
+    /// Subscribe to block header announcement requests.
+    virtual void subscribe_header_announcement(headers_handler handler);
+
+    /// Subscribe to transaction announcement requests.
+    virtual void subscribe_transaction_announcement(
+        transaction_handler handler);
+
+    /// Request announcement of inventory to the peer.
+    virtual void announce(inventory_const_ptr inventory, uint64_t fee_rate);
+
+    /// Request announcement of block headers to the peer.
+    virtual void announce(headers_const_ptr headers);
+
+    /// Request announcement of a transaction to the peer.
+    virtual void announce(transaction_const_ptr transaction,
+        uint64_t fee_rate);
+
     // Properties.
 
     virtual bool notify() const;
@@ -57,7 +94,35 @@ public:
     virtual version_const_ptr peer_version() const;
     virtual void set_peer_version(version_const_ptr value);
 
+    virtual hash_digest best_known_header() const;
+    virtual void set_best_known_header(const hash_digest& value);
+
+    virtual uint64_t fee_filter() const;
+    virtual void set_fee_filter(uint64_t value);
+
+    virtual bloom_filter::ptr filter() const;
+    virtual void set_filter(bloom_filter::ptr value);
+
+    virtual reconciliation_set::ptr reconciliation() const;
+    virtual void set_reconciliation(reconciliation_set::ptr value);
+
+    virtual bool address_relay() const;
+    virtual void set_address_relay(bool value);
+
+    virtual bool anchor() const;
+    virtual void set_anchor(bool value);
+
+    virtual asio::duration latency() const;
+    virtual void set_latency(const asio::duration& value);
+
+    virtual asio::duration uptime() const;
+
+    /// Set a handler invoked upon lifetime expiration, before the channel
+    /// stops, so that the channel may be replaced before it is lost.
+    virtual void set_expiration_handler(result_handler handler);
+
 protected:
+    virtual void sending(const message::headers& message) override;
     virtual void signal_activity() override;
     virtual void handle_stopping() override;
     virtual bool stopped(const code& ec) const;
@@ -74,8 +139,20 @@ private:
     std::atomic<bool> notify_;
     std::atomic<uint64_t> nonce_;
     bc::atomic<version_const_ptr> peer_version_;
+    bc::atomic<hash_digest> best_known_header_;
+    std::atomic<uint64_t> fee_filter_;
+    bc::atomic<bloom_filter::ptr> filter_;
+    bc::atomic<reconciliation_set::ptr> reconciliation_;
+    std::atomic<bool> address_relay_;
+    std::atomic<bool> anchor_;
+    bc::atomic<asio::duration> latency_;
+    const asio::time_point created_;
+    bc::atomic<result_handler> expiration_handler_;
     deadline::ptr expiration_;
     deadline::ptr inactivity_;
+    announce_subscriber::ptr announce_subscriber_;
+    headers_subscriber::ptr headers_subscriber_;
+    transaction_subscriber::ptr transaction_subscriber_;
 };
 
 } // namespace network
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_COMPACT_BLOCK_RELAY_HPP
+#define LIBBITCOIN_NETWORK_COMPACT_BLOCK_RELAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/rolling_bloom_filter.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Coordinates compact block relay (bip152) across channels, thread safe.
+/// At most three peers are selected for high bandwidth relay, as the peer
+/// sends compact blocks before validation. Each block is reconstructed from
+/// only one peer at a time, so compact blocks of a block that is complete or
+/// claimed by another peer are dropped. A claim lapses after a timeout.
+class BCT_API compact_block_relay
+  : noncopyable
+{
+public:
+    typedef std::shared_ptr<compact_block_relay> ptr;
+
+    /// Construct an instance.
+    compact_block_relay();
+
+    /// Select the peer for high bandwidth relay, false if there is no slot.
+    virtual bool select(uint64_t peer);
+
+    /// Unregister a peer, releasing its selection and claims.
+    virtual void disconnect(uint64_t peer);
+
+    /// Claim the block for reconstruction from the peer, false if complete
+    /// or claimed by another peer.
+    virtual bool claim(uint64_t peer, const hash_digest& hash);
+
+    /// The block is complete, releasing any claim.
+    virtual void completed(const hash_digest& hash);
+
+    /// The number of peers selected for high bandwidth relay.
+    virtual size_t high_bandwidth() const;
+
+private:
+    struct claim_entry
+    {
+        uint64_t peer;
+        asio::time_point time;
+    };
+
+    // These are thread safe.
+    const asio::duration timeout_;
+
+    // These are protected by mutex.
+    std::set<uint64_t> selected_;
+    std::map<hash_digest, claim_entry> claims_;
+    rolling_bloom_filter completed_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
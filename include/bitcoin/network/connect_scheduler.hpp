@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_CONNECT_SCHEDULER_HPP
+#define LIBBITCOIN_NETWORK_CONNECT_SCHEDULER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Schedules outbound connection attempts, thread safe.
+/// A host that fails to connect is not dialed again until a jittered delay
+/// has elapsed, which doubles with each consecutive failure. The connect
+/// timeout tracks the observed round trip time of established connections
+/// (as a retransmission timeout), bounded by the configured timeout.
+class BCT_API connect_scheduler
+  : noncopyable
+{
+public:
+    typedef std::shared_ptr<connect_scheduler> ptr;
+
+    /// Construct an instance.
+    connect_scheduler(const settings& settings);
+
+    /// The timeout for a connection attempt.
+    virtual asio::duration timeout() const;
+
+    /// A connection was established in the given round trip time.
+    virtual void sampled(const asio::duration& round_trip);
+
+    /// A connection attempt timed out.
+    virtual void timed_out();
+
+    /// The host failed to connect, so defer its next attempt.
+    virtual void failed(const config::endpoint& host);
+
+    /// The host connected, so forget its failures.
+    virtual void succeeded(const config::endpoint& host);
+
+    /// The time remaining before the host should be dialed again.
+    virtual asio::duration delay(const config::endpoint& host) const;
+
+private:
+    typedef std::pair<std::string, uint16_t> key;
+
+    struct entry
+    {
+        size_t failures;
+        asio::time_point retry;
+    };
+
+    void prune(const asio::time_point& now);
+
+    // These are thread safe.
+    const asio::duration maximum_timeout_;
+    const asio::duration minimum_delay_;
+
+    // These are protected by mutex.
+    bool sampled_;
+    asio::duration smoothed_;
+    asio::duration variation_;
+    asio::duration timeout_;
+    std::map<key, entry> hosts_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -25,6 +25,7 @@
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/connect_scheduler.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/settings.hpp>
 
@@ -40,9 +41,13 @@ class BCT_API connector
 public:
     typedef std::shared_ptr<connector> ptr;
     typedef std::function<void(const code& ec, channel::ptr)> connect_handler;
+    typedef message::network_address::list address_list;
+    typedef std::function<void(const code& ec, const address_list&)>
+        resolve_handler;
 
     /// Construct an instance.
-    connector(threadpool& pool, const settings& settings);
+    connector(threadpool& pool, const settings& settings,
+        connect_scheduler::ptr scheduler);
 
     /// Validate connector stopped.
     ~connector();
@@ -59,6 +64,10 @@ public:
     virtual void connect(const std::string& hostname, uint16_t port,
         connect_handler handler);
 
+    /// Resolve the endpoint to an address for each of its A/AAAA records.
+    virtual void resolve(const config::endpoint& endpoint,
+        resolve_handler handler);
+
     /// Cancel outstanding connection attempt.
     void stop(const code& ec);
 
@@ -69,8 +78,11 @@ private:
 
     void handle_resolve(const boost_code& ec, asio::iterator iterator,
         connect_handler handler);
+    void handle_records(const boost_code& ec, asio::iterator iterator,
+        resolve_handler handler);
     void handle_connect(const boost_code& ec, asio::iterator iterator,
-        socket::ptr socket, connect_handler handler);
+        socket::ptr socket, const asio::time_point& started,
+        connect_handler handler);
     void handle_timer(const code& ec, socket::ptr socket,
         connect_handler handler);
 
@@ -78,6 +90,7 @@ private:
     std::atomic<bool> stopped_;
     threadpool& pool_;
     const settings& settings_;
+    const connect_scheduler::ptr scheduler_;
     mutable dispatcher dispatch_;
 
     // These are protected by mutex.
@@ -36,6 +36,8 @@ namespace network {
 /// The store can be loaded and saved from/to the specified file path.
 /// The file is a line-oriented set of config::authority serializations.
 /// Duplicate addresses and those with zero-valued ports are disacarded.
+/// Anchors (the best outbound peers at shutdown) are saved to a separate file
+/// and fetched ahead of random selection upon the next start.
 class BCT_API hosts
   : noncopyable
 {
@@ -55,24 +57,32 @@ public:
 
     virtual size_t count() const;
     virtual code fetch(address& out) const;
+    virtual address::list sample(size_t count) const;
     virtual code remove(const address& host);
     virtual code store(const address& host);
     virtual void store(const address::list& hosts, result_handler handler);
 
+    virtual code fetch_anchor(address& out);
+    virtual void save_anchors(const address::list& anchors);
+
 private:
     typedef boost::circular_buffer<address> list;
     typedef list::iterator iterator;
 
     iterator find(const address& host);
+    void read_anchors();
+    void write_anchors();
 
     // These are protected by a mutex.
     list buffer_;
+    address::list anchors_;
     std::atomic<bool> stopped_;
     mutable upgrade_mutex mutex_;
 
     // HACK: we use this because the buffer capacity cannot be set to zero.
     const bool disabled_;
     const boost::filesystem::path file_path_;
+    const boost::filesystem::path anchors_path_;
 };
 
 } // namespace network
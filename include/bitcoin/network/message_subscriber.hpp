@@ -27,6 +27,7 @@
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
+#include <bitcoin/network/wire_payload.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -50,11 +51,26 @@ template <class Message>
 using message_handler =
     std::function<bool(const code&, std::shared_ptr<const Message>)>;
 
+/// Delivery of a received message to the subscribers of its type.
+enum class delivery
+{
+    /// Invoke subscribers on the read thread, blocking the peer.
+    handle,
+
+    /// Post subscribers to the network threadpool.
+    relay,
+
+    /// Post subscribers in order to the dedicated threadpool, if set.
+    dedicated
+};
+
 /// Aggregation of subscribers by messasge type, thread safe.
 class BCT_API message_subscriber
   : noncopyable
 {
 public:
+    typedef std::function<void()> completion_handler;
+
     DEFINE_SUBSCRIBER_TYPE(address);
     DEFINE_SUBSCRIBER_TYPE(alert);
     DEFINE_SUBSCRIBER_TYPE(block);
@@ -101,26 +117,35 @@ public:
         subscribe(Message(), std::forward<Handler>(handler));
     }
 
+    /**
+     * Create a default message instance.
+     * @param[in]  payload  The wire payload to retain, if its data is set.
+     * @return              The new message instance.
+     */
+    template <class Message>
+    std::shared_ptr<Message> create(const wire_payload& payload) const
+    {
+        if (payload.data)
+            return std::shared_ptr<Message>(new Message,
+                wire_deleter<Message>(payload));
+
+        return std::make_shared<Message>();
+    }
+
     /**
      * Load a stream into a message instance and notify subscribers.
      * @param[in]  stream      The stream from which to load the message.
      * @param[in]  version     The peer protocol version.
      * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  complete    Invoked once all subscribers have been invoked.
      * @return                 Returns error::bad_stream if failed.
      */
     template <class Message, class Subscriber>
     code relay(std::istream& stream, uint32_t version,
-        Subscriber& subscriber) const
+        Subscriber& subscriber, completion_handler complete) const
     {
-        const auto message = std::make_shared<Message>();
-
-        // Subscribers are invoked only with stop and success codes.
-        if (!message->from_data(version, stream))
-            return error::bad_stream;
-
-        ////const auto const_ptr = std::const_pointer_cast<const Message>(message);
-        subscriber->relay(error::success, message);
-        return error::success;
+        return load<Message>(delivery::relay, stream, version, subscriber,
+            complete, {});
     }
 
     /**
@@ -128,23 +153,122 @@ public:
      * @param[in]  stream      The stream from which to load the message.
      * @param[in]  version     The peer protocol version.
      * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  complete    Invoked once all subscribers have been invoked.
      * @return                 Returns error::bad_stream if failed.
      */
     template <class Message, class Subscriber>
     code handle(std::istream& stream, uint32_t version,
-        Subscriber& subscriber) const
+        Subscriber& subscriber, completion_handler complete) const
+    {
+        return load<Message>(delivery::handle, stream, version, subscriber,
+            complete, {});
+    }
+
+    /**
+     * Load a stream into a message instance and invoke subscribers in order
+     * on the dedicated threadpool, or relay if there is no dedicated pool.
+     * @param[in]  stream      The stream from which to load the message.
+     * @param[in]  version     The peer protocol version.
+     * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  complete    Invoked once all subscribers have been invoked.
+     * @return                 Returns error::bad_stream if failed.
+     */
+    template <class Message, class Subscriber>
+    code dedicate(std::istream& stream, uint32_t version,
+        Subscriber& subscriber, completion_handler complete) const
+    {
+        return load<Message>(delivery::dedicated, stream, version, subscriber,
+            complete, {});
+    }
+
+    /**
+     * Load a stream into a message instance and deliver it to subscribers.
+     * @param[in]  policy      The delivery policy.
+     * @param[in]  stream      The stream from which to load the message.
+     * @param[in]  version     The peer protocol version.
+     * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  complete    Invoked once all subscribers have been invoked.
+     * @param[in]  payload     The wire payload to retain, if its data is set.
+     * @return                 Returns error::bad_stream if failed.
+     */
+    template <class Message, class Subscriber>
+    code load(delivery policy, std::istream& stream, uint32_t version,
+        Subscriber& subscriber, completion_handler complete,
+        const wire_payload& payload) const
     {
-        const auto message = std::make_shared<Message>();
+        const auto message = create<Message>(payload);
 
         // Subscribers are invoked only with stop and success codes.
         if (!message->from_data(version, stream))
             return error::bad_stream;
 
         ////const auto const_ptr = std::const_pointer_cast<const Message>(message);
-        subscriber->invoke(error::success, message);
+        notify(policy, message, subscriber, complete);
         return error::success;
     }
 
+    /**
+     * Deliver a message instance to subscribers.
+     * @param[in]  policy      The delivery policy.
+     * @param[in]  message     The message instance.
+     * @param[in]  subscriber  The subscriber for the message type.
+     * @param[in]  complete    Invoked once all subscribers have been invoked.
+     */
+    template <class Message, class Subscriber>
+    void notify(delivery policy, std::shared_ptr<Message> message,
+        Subscriber& subscriber, completion_handler complete) const
+    {
+        const auto target = subscriber;
+        const auto dedicated = dedicated_.load();
+        const auto deliver = [target, message, complete]()
+        {
+            target->invoke(error::success, message);
+            complete();
+        };
+
+        switch (policy)
+        {
+            // This allows us to block the peer while handling the message.
+            case delivery::handle:
+                deliver();
+                return;
+
+            case delivery::dedicated:
+                if (dedicated)
+                {
+                    dedicated->ordered(deliver);
+                    return;
+                }
+
+                // Relay if there is no dedicated pool.
+            case delivery::relay:
+            default:
+                dispatch_.concurrent(deliver);
+                return;
+        }
+    }
+
+    /**
+     * Get the delivery policy for messages of the specified type.
+     * @param[in]  type  The message type identifier.
+     * @return           The delivery policy.
+     */
+    virtual delivery delivery_policy(message::message_type type) const;
+
+    /**
+     * Set the delivery policy for messages of the specified type.
+     * @param[in]  type    The message type identifier.
+     * @param[in]  policy  The delivery policy.
+     */
+    virtual void set_delivery_policy(message::message_type type,
+        delivery policy);
+
+    /**
+     * Set the threadpool used for dedicated delivery.
+     * @param[in]  pool  The dedicated threadpool, must outlive this instance.
+     */
+    virtual void set_dedicated_pool(threadpool& pool);
+
     /**
      * Broadcast a default message instance with the specified error code.
      * @param[in]  ec  The error code to broadcast.
@@ -163,6 +287,46 @@ public:
     virtual code load(message::message_type type, uint32_t version,
         std::istream& stream) const;
 
+    /*
+     * Load a stream of the specified command type.
+     * Creates an instance of the indicated message type.
+     * Sends the message instance to each subscriber of the type.
+     * @param[in]  type      The stream message type identifier.
+     * @param[in]  version   The peer protocol version.
+     * @param[in]  stream    The stream from which to load the message.
+     * @param[in]  complete  Invoked once all subscribers have been invoked,
+     *                       unless the load fails.
+     * @return               Returns error::bad_stream if failed.
+     */
+    virtual code load(message::message_type type, uint32_t version,
+        std::istream& stream, completion_handler complete) const;
+
+    /*
+     * Load a stream of the specified command type, retaining its payload.
+     * Creates an instance of the indicated message type.
+     * Sends the message instance to each subscriber of the type.
+     * @param[in]  type      The stream message type identifier.
+     * @param[in]  version   The peer protocol version.
+     * @param[in]  stream    The stream from which to load the message.
+     * @param[in]  payload   The verified payload of the stream, retained by
+     *                       the message if its data is set.
+     * @param[in]  complete  Invoked once all subscribers have been invoked,
+     *                       unless the load fails.
+     * @return               Returns error::bad_stream if failed.
+     */
+    virtual code load(message::message_type type, uint32_t version,
+        std::istream& stream, const wire_payload& payload,
+        completion_handler complete) const;
+
+    /*
+     * Notify block subscribers of a block that has already been parsed.
+     * @param[in]  block     The block parsed incrementally from the payload.
+     * @param[in]  complete  Invoked once all subscribers have been invoked.
+     * @return               Returns error::success.
+     */
+    virtual code load(block_const_ptr block,
+        completion_handler complete) const;
+
     /**
      * Start all subscribers so that they accept subscription.
      */
@@ -174,6 +338,15 @@ public:
     virtual void stop();
 
 private:
+    typedef std::map<message::message_type, delivery> delivery_map;
+
+    mutable dispatcher dispatch_;
+    bc::atomic<std::shared_ptr<dispatcher>> dedicated_;
+
+    // This is protected by mutex.
+    delivery_map delivery_;
+    mutable shared_mutex mutex_;
+
     DEFINE_SUBSCRIBER_OVERLOAD(address);
     DEFINE_SUBSCRIBER_OVERLOAD(alert);
     DEFINE_SUBSCRIBER_OVERLOAD(block);
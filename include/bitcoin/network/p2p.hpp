@@ -23,19 +23,29 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/address_gossip.hpp>
+#include <bitcoin/network/block_scheduler.hpp>
+#include <bitcoin/network/block_source.hpp>
 #include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/compact_block_relay.hpp>
+#include <bitcoin/network/connect_scheduler.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/hosts.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
+#include <bitcoin/network/sessions/session_block_relay.hpp>
 #include <bitcoin/network/sessions/session_inbound.hpp>
 #include <bitcoin/network/sessions/session_manual.hpp>
 #include <bitcoin/network/sessions/session_outbound.hpp>
 #include <bitcoin/network/sessions/session_seed.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/transaction_scheduler.hpp>
+#include <bitcoin/network/transaction_source.hpp>
+#include <bitcoin/network/upload_shaper.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -72,10 +82,22 @@ public:
         const auto join_handler = synchronize(handle_complete, channels.size(),
             "p2p_join", synchronizer_terminate::on_count);
 
-        // No pre-serialize, channels may have different protocol versions.
+        // Serialize once for each protocol version among the channels.
+        std::map<uint32_t, proxy::data_ptr> framed;
+
         for (const auto channel: channels)
-            channel->send(message, std::bind(&p2p::handle_send, this,
-                std::placeholders::_1, channel, handle_channel, join_handler));
+        {
+            const auto version = channel->negotiated_version();
+            auto& data = framed[version];
+
+            if (!data)
+                data = std::make_shared<const data_chunk>(message::serialize(
+                    version, message, settings_.identifier));
+
+            channel->send(message, data,
+                std::bind(&p2p::handle_send, this, std::placeholders::_1,
+                    channel, handle_channel, join_handler));
+        }
     }
 
     // Constructors.
@@ -130,6 +152,43 @@ public:
     /// Return a reference to the network threadpool.
     virtual threadpool& thread_pool();
 
+    /// Return a reference to the threadpool for dedicated message delivery.
+    virtual threadpool& dedicated_pool();
+
+    /// Return the upload shaper shared by all channels. Channels are shaped
+    /// only if an upload rate is configured when they start.
+    virtual upload_shaper::ptr shaper();
+
+    /// Return the transaction download scheduler shared by all channels.
+    virtual transaction_scheduler::ptr transaction_downloads();
+
+    /// Return the block download scheduler shared by outbound channels.
+    virtual block_scheduler::ptr block_downloads();
+
+    /// Return the compact block relay coordinator shared by all channels.
+    virtual compact_block_relay::ptr compact_blocks();
+
+    /// Return the connect scheduler (backoff and timeout) of all connectors.
+    virtual connect_scheduler::ptr connect_attempts();
+
+    /// Return the source of transactions for compact block reconstruction.
+    virtual transaction_source::ptr transaction_pool() const;
+
+    /// Set the source of transactions for compact block reconstruction.
+    virtual void set_transaction_pool(transaction_source::ptr pool);
+
+    /// Return the minimum fee rate of transactions relayed to us (bip133).
+    virtual uint64_t fee_floor() const;
+
+    /// Set the minimum fee rate (satoshis per kilobyte), zero for none.
+    virtual void set_fee_floor(uint64_t fee_rate);
+
+    /// Return the source of blocks for serving filtered blocks.
+    virtual block_source::ptr block_store() const;
+
+    /// Set the source of blocks for serving filtered blocks.
+    virtual void set_block_store(block_source::ptr store);
+
     // Subscriptions.
     // ------------------------------------------------------------------------
 
@@ -139,6 +198,30 @@ public:
     /// Subscribe to service stop event.
     virtual void subscribe_stop(result_handler handler);
 
+    // Announcements.
+    // ------------------------------------------------------------------------
+
+    /// Announce inventory to all connections, batched and trickled per
+    /// channel, omitting items known to each peer. Blocks are not delayed.
+    /// Announcements are requested of each channel (see channel::announce).
+    virtual void announce(const message::inventory_vector::list& items);
+
+    /// Announce transactions paying at least the fee rate (satoshis per
+    /// kilobyte), omitted for peers that filter below the rate (bip133).
+    virtual void announce(const message::inventory_vector::list& items,
+        uint64_t fee_rate);
+
+    /// Announce new blocks to all connections, as headers to peers that
+    /// negotiated bip130 (if send_headers is configured) and as inventory
+    /// otherwise. The headers must be ordered and connected, ending with the
+    /// new top block.
+    virtual void announce(const chain::header::list& headers);
+
+    /// Announce a transaction paying the fee rate (satoshis per kilobyte),
+    /// which is matched against the filter of each peer that set one (bip37).
+    virtual void announce(transaction_const_ptr transaction,
+        uint64_t fee_rate);
+
     // Manual connections.
     // ----------------------------------------------------------------------------
 
@@ -165,9 +248,21 @@ public:
     /// Store a collection of addresses (asynchronous).
     virtual void store(const address::list& addresses, result_handler handler);
 
+    /// Queue gossiped addresses for batched storage (asynchronous).
+    virtual void gossip(const address::list& addresses);
+
+    /// Relay fresh addresses to a small random set of peers other than source.
+    virtual void relay(const address::list& addresses, channel::ptr source);
+
     /// Get a randomly-selected address.
     virtual code fetch_address(address& out_address) const;
 
+    /// Get the next anchor (peer of the previous run) to be dialed, if any.
+    virtual code fetch_anchor(address& out_address);
+
+    /// Get a cached random sample of addresses (for get_address responses).
+    virtual address_const_ptr fetch_addresses() const;
+
     /// Remove an address.
     virtual code remove(const address& address);
 
@@ -221,6 +316,7 @@ protected:
     virtual session_manual::ptr attach_manual_session();
     virtual session_inbound::ptr attach_inbound_session();
     virtual session_outbound::ptr attach_outbound_session();
+    virtual session_block_relay::ptr attach_block_relay_session();
 
 private:
     typedef bc::pending<channel> pending_channels;
@@ -228,10 +324,14 @@ private:
 
     void handle_manual_started(const code& ec, result_handler handler);
     void handle_inbound_started(const code& ec, result_handler handler);
+    void handle_outbound_started(const code& ec, result_handler handler);
+    address::list anchors() const;
+    void load_hosts(result_handler handler);
     void handle_hosts_loaded(const code& ec, result_handler handler);
     void handle_hosts_saved(const code& ec, result_handler handler);
     void handle_send(const code& ec, channel::ptr channel,
         channel_handler handle_channel, result_handler handle_complete);
+    void handle_relay(const code& ec, channel::ptr channel);
 
     void handle_started(const code& ec, result_handler handler);
     void handle_running(const code& ec, result_handler handler);
@@ -242,7 +342,17 @@ private:
     bc::atomic<config::checkpoint> top_block_;
     bc::atomic<session_manual::ptr> manual_;
     threadpool threadpool_;
+    threadpool dedicated_pool_;
+    upload_shaper::ptr shaper_;
+    transaction_scheduler::ptr transaction_scheduler_;
+    block_scheduler::ptr block_scheduler_;
+    compact_block_relay::ptr compact_block_relay_;
+    connect_scheduler::ptr connect_scheduler_;
+    bc::atomic<transaction_source::ptr> transaction_pool_;
+    std::atomic<uint64_t> fee_floor_;
+    bc::atomic<block_source::ptr> block_store_;
     hosts hosts_;
+    address_gossip::ptr gossip_;
     pending_connectors pending_connect_;
     pending_channels pending_handshake_;
     pending_channels pending_close_;
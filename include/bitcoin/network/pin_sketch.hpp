@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PIN_SKETCH_HPP
+#define LIBBITCOIN_NETWORK_PIN_SKETCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A sketch of a set of nonzero 32 bit elements (pinsketch, as minisketch),
+/// not thread safe. The sketch holds the odd power sums of the elements over
+/// GF(2^32), so merging two sketches of equal capacity yields the sketch of
+/// the symmetric difference of the sets, which can be decoded when it does
+/// not exceed the capacity.
+class BCT_API pin_sketch
+{
+public:
+    typedef std::vector<uint32_t> elements;
+
+    /// Construct an empty sketch of the given capacity.
+    explicit pin_sketch(size_t capacity);
+
+    /// Construct a sketch from its serialization (capacity is size / 4).
+    explicit pin_sketch(const data_chunk& data);
+
+    /// The maximum number of elements that can be decoded.
+    size_t capacity() const;
+
+    /// Add (or remove, if present) the element, zero is ignored.
+    void add(uint32_t element);
+
+    /// Combine with a sketch of equal capacity (symmetric difference).
+    bool merge(const pin_sketch& other);
+
+    /// Decode the elements, false if the set exceeds the capacity.
+    bool decode(elements& out) const;
+
+    /// Serialize the sketch (four bytes per unit of capacity).
+    data_chunk to_data() const;
+
+private:
+    elements syndromes_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -19,6 +19,7 @@
 #ifndef LIBBITCOIN_NETWORK_PROTOCOL_ADDRESS_31402_HPP
 #define LIBBITCOIN_NETWORK_PROTOCOL_ADDRESS_31402_HPP
 
+#include <cstddef>
 #include <memory>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
@@ -32,6 +33,9 @@ class p2p;
 
 /**
  * Address protocol.
+ * Addresses accepted from the peer are limited by a token bucket, queued for
+ * batched storage in the host pool and, if from a small message and recently
+ * timestamped, relayed to a small random set of other peers.
  * Attach this to a channel immediately following handshake completion.
  */
 class BCT_API protocol_address_31402
@@ -40,6 +44,10 @@ class BCT_API protocol_address_31402
 public:
     typedef std::shared_ptr<protocol_address_31402> ptr;
 
+    /// Refill the token bucket (0.1 per second, up to 1000) for the elapsed
+    /// milliseconds and consume up to count tokens, returning those consumed.
+    static size_t admit(double& tokens, size_t elapsed, size_t count);
+
     /**
      * Construct an address protocol instance.
      * @param[in]  network   The network interface.
@@ -54,7 +62,6 @@ public:
 
 protected:
     virtual void handle_stop(const code& ec);
-    virtual void handle_store_addresses(const code& ec);
 
     virtual bool handle_receive_address(const code& ec,
         address_const_ptr address);
@@ -62,7 +69,16 @@ protected:
         get_address_const_ptr message);
 
     p2p& network_;
+    const channel::ptr channel_;
     const message::address self_;
+
+private:
+    size_t admit(size_t count);
+
+    // These are protected by mutex.
+    double tokens_;
+    asio::time_point refilled_;
+    mutable shared_mutex mutex_;
 };
 
 } // namespace network
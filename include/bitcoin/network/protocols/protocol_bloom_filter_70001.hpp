@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_BLOOM_FILTER_70001_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_BLOOM_FILTER_70001_HPP
+
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/bloom_filter.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Bloom filter protocol (BIP37), for serving light clients.
+ * Maintains the peer transaction filter on the channel, which restricts
+ * transaction announcements to the peer (see protocol_inventory). Requests
+ * for filtered blocks are answered with a merkle block and the matching
+ * transactions, from the network block store (see p2p::set_block_store).
+ * Filters exceeding bip37 limits stop the channel, and filter matching is
+ * limited to a time budget per second (bloom_filter_budget_milliseconds).
+ * Attach this to a channel immediately following bip37 handshake completion.
+ */
+class BCT_API protocol_bloom_filter_70001
+  : public protocol_events, track<protocol_bloom_filter_70001>
+{
+public:
+    typedef std::shared_ptr<protocol_bloom_filter_70001> ptr;
+
+    /**
+     * Construct a bloom filter protocol instance.
+     * @param[in]  network   The network interface.
+     * @param[in]  channel   The channel on which to start the protocol.
+     */
+    protocol_bloom_filter_70001(p2p& network, channel::ptr channel);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+protected:
+    virtual bool handle_receive_filter_load(const code& ec,
+        filter_load_const_ptr message);
+    virtual bool handle_receive_filter_add(const code& ec,
+        filter_add_const_ptr message);
+    virtual bool handle_receive_filter_clear(const code& ec,
+        filter_clear_const_ptr message);
+    virtual bool handle_receive_get_data(const code& ec,
+        get_data_const_ptr message);
+
+    virtual bool send_merkle_block(const hash_digest& hash,
+        bloom_filter::ptr filter);
+
+    p2p& network_;
+    const channel::ptr channel_;
+    const asio::duration budget_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_COMPACT_BLOCK_70014_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_COMPACT_BLOCK_70014_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/compact_block_relay.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Compact block protocol (BIP152).
+ * Requests compact block announcements from the peer, in high bandwidth mode
+ * if selected (see p2p::compact_blocks) and otherwise in low bandwidth mode,
+ * where a single announced block is requested as a compact block. Announced
+ * blocks are reconstructed from the network transaction pool (see
+ * p2p::set_transaction_pool). Missing transactions are requested with
+ * get_block_transactions and the full block is requested if reconstruction
+ * fails. Reconstructed blocks are delivered to the channel block subscribers.
+ * A low bandwidth peer that delivers a block is selected if there is a slot.
+ * Requests for compact blocks and block transactions are answered from the
+ * block store (see p2p::set_block_store), but new blocks are not announced
+ * as compact blocks, and compact blocks are served regardless of depth.
+ * Attach this to a channel immediately following bip152 handshake completion.
+ */
+class BCT_API protocol_compact_block_70014
+  : public protocol_events, track<protocol_compact_block_70014>
+{
+public:
+    typedef std::shared_ptr<protocol_compact_block_70014> ptr;
+
+    /**
+     * Construct a compact block protocol instance.
+     * @param[in]  network         The network interface.
+     * @param[in]  channel         The channel on which to start the protocol.
+     * @param[in]  high_bandwidth  Request unsolicited compact blocks, if
+     *                             the peer is selected.
+     */
+    protocol_compact_block_70014(p2p& network, channel::ptr channel,
+        bool high_bandwidth);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+protected:
+    // A block awaiting the response to get_block_transactions.
+    struct reconstruction
+    {
+        chain::header header;
+        chain::transaction::list transactions;
+        std::vector<uint64_t> missing;
+    };
+
+    typedef std::unordered_map<hash_digest, reconstruction> reconstructions;
+
+    virtual void handle_stop(const code& ec);
+    virtual void request_block(const hash_digest& hash);
+    virtual void request_compact_block(const hash_digest& hash);
+    virtual void send_compact_request(bool high_bandwidth);
+    virtual void complete(const chain::header& header,
+        chain::transaction::list&& transactions);
+    virtual bool send_compact_block(const hash_digest& hash);
+
+    virtual bool handle_receive_compact_block(const code& ec,
+        compact_block_const_ptr message);
+    virtual bool handle_receive_block_transactions(const code& ec,
+        block_transactions_const_ptr message);
+    virtual bool handle_receive_inventory(const code& ec,
+        inventory_const_ptr message);
+    virtual bool handle_receive_headers(const code& ec,
+        headers_const_ptr message);
+    virtual bool handle_receive_block(const code& ec,
+        block_const_ptr message);
+    virtual bool handle_receive_get_data(const code& ec,
+        get_data_const_ptr message);
+    virtual bool handle_receive_get_block_transactions(const code& ec,
+        get_block_transactions_const_ptr message);
+
+    p2p& network_;
+    const channel::ptr channel_;
+    const compact_block_relay::ptr relay_;
+    const bool high_bandwidth_;
+    const uint64_t compact_version_;
+
+private:
+    // This is thread safe.
+    std::atomic<bool> selected_;
+
+    // This is protected by mutex.
+    reconstructions pending_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_FEE_FILTER_70013_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_FEE_FILTER_70013_HPP
+
+#include <cstdint>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_timer.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Fee filter protocol (BIP133).
+ * Sends the network fee floor (see p2p::set_fee_floor) to the peer, rounded
+ * and randomized for privacy, when it changes beyond a hysteresis band.
+ * Records the fee filter of the peer on the channel, which excludes lower
+ * fee transactions from announcement to the peer.
+ * Attach this to a channel immediately following bip133 handshake completion.
+ */
+class BCT_API protocol_fee_filter_70013
+  : public protocol_timer, track<protocol_fee_filter_70013>
+{
+public:
+    typedef std::shared_ptr<protocol_fee_filter_70013> ptr;
+
+    /// Determine if the fee floor changed beyond the hysteresis band.
+    static bool changed(uint64_t previous, uint64_t current);
+
+    /// Round the fee rate down to its fee rate bucket, or at random to the
+    /// next lower bucket.
+    static uint64_t round_fee(uint64_t fee_rate);
+
+    /**
+     * Construct a fee filter protocol instance.
+     * @param[in]  network   The network interface.
+     * @param[in]  channel   The channel on which to start the protocol.
+     */
+    protocol_fee_filter_70013(p2p& network, channel::ptr channel);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+protected:
+    virtual void send_fee_filter(const code& ec);
+    virtual bool handle_receive_fee_filter(const code& ec,
+        fee_filter_const_ptr message);
+
+    p2p& network_;
+    const channel::ptr channel_;
+
+private:
+    // The unrounded fee floor last sent, so rounding does not cause resends.
+    uint64_t floor_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_INVENTORY_31402_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_INVENTORY_31402_HPP
+
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/rolling_bloom_filter.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Inventory announcement protocol.
+ * Announcements made via p2p::announce are queued for the channel, omitting
+ * hashes the peer is known to have, transactions below the peer fee filter
+ * (see fee_filter) and transactions that do not match the peer transaction
+ * filter (see bloom_filter), and sent in batches on a randomized trickle
+ * interval. Transactions not flooded to a reconciling peer are instead added
+ * to its reconciliation set (see protocol_reconciliation). Block
+ * announcements are sent without delay, including header announcements to
+ * peers that precede bip130 or if send_headers is not configured (see
+ * protocol_send_headers). Transactions are never
+ * announced to block-relay-only channels (see session_block_relay).
+ * Attach this to a channel immediately following handshake completion.
+ */
+class BCT_API protocol_inventory_31402
+  : public protocol_events, track<protocol_inventory_31402>
+{
+public:
+    typedef std::shared_ptr<protocol_inventory_31402> ptr;
+
+    /**
+     * Construct an inventory protocol instance.
+     * @param[in]  network   The network interface.
+     * @param[in]  channel   The channel on which to start the protocol.
+     * @param[in]  transactions  Announce transactions to the peer.
+     */
+    protocol_inventory_31402(p2p& network, channel::ptr channel,
+        bool transactions);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+protected:
+    virtual void handle_stop(const code& ec);
+    virtual void handle_trickle(const code& ec);
+
+    virtual bool handle_announce(const code& ec,
+        inventory_const_ptr message, uint64_t fee_rate);
+    virtual bool handle_announce_headers(const code& ec,
+        headers_const_ptr message);
+    virtual bool handle_announce_transaction(const code& ec,
+        transaction_const_ptr message, uint64_t fee_rate);
+    virtual bool handle_receive_inventory(const code& ec,
+        inventory_const_ptr message);
+    virtual bool handle_receive_transaction(const code& ec,
+        transaction_const_ptr message);
+
+    p2p& network_;
+    const channel::ptr channel_;
+
+private:
+    typedef message::inventory_vector::list list;
+
+    void start_trickle();
+    void send_inventory(list&& items);
+    void set_known(const hash_digest& hash);
+
+    const bool relay_;
+    const asio::duration trickle_;
+    const deadline::ptr timer_;
+
+    // These are protected by mutex.
+    list pending_;
+    rolling_bloom_filter known_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -60,7 +60,9 @@ protected:
         uint64_t nonce);
 
 private:
+    const channel::ptr channel_;
     std::atomic<bool> pending_;
+    bc::atomic<asio::time_point> sent_;
 };
 
 } // namespace network
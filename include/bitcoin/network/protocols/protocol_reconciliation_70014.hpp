@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_RECONCILIATION_70014_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_RECONCILIATION_70014_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_timer.hpp>
+#include <bitcoin/network/reconciliation_set.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Transaction reconciliation protocol (erlay, after BIP330).
+ * Negotiates reconciliation with rcnlregister (private commands, as this is
+ * not wire compatible with bip330), after which transactions are flooded to
+ * the peer only at the configured fanout rate (outbound) or not at all
+ * (inbound), and otherwise added to the channel reconciliation set
+ * (see protocol_inventory). The initiator (outbound) requests a sketch of
+ * the peer set on a timer, decodes the set difference, announces what the
+ * peer lacks and requests the announcement of what it lacks. A failed
+ * reconciliation announces both sets in full, and one not completed by the
+ * next interval announces the initiator set in full.
+ * Attach this to a channel immediately following handshake completion.
+ */
+class BCT_API protocol_reconciliation_70014
+  : public protocol_timer, track<protocol_reconciliation_70014>
+{
+public:
+    typedef std::shared_ptr<protocol_reconciliation_70014> ptr;
+
+    /**
+     * Construct a reconciliation protocol instance.
+     * @param[in]  network    The network interface.
+     * @param[in]  channel    The channel on which to start the protocol.
+     * @param[in]  initiator  Request reconciliations of the peer.
+     */
+    protocol_reconciliation_70014(p2p& network, channel::ptr channel,
+        bool initiator);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+protected:
+    virtual void send_request(const code& ec);
+    virtual bool handle_receive(const code& ec,
+        const message::heading& head, proxy::data_ptr payload);
+
+    virtual void handle_register(const data_chunk& payload);
+    virtual void handle_request(const data_chunk& payload);
+    virtual void handle_sketch(const data_chunk& payload);
+    virtual void handle_difference(const data_chunk& payload);
+
+    virtual void send_message(const std::string& command,
+        data_chunk&& payload);
+    virtual void announce(const hash_list& hashes);
+
+    p2p& network_;
+    const channel::ptr channel_;
+    const bool initiator_;
+    const uint64_t salt_;
+    const double flood_rate_;
+
+private:
+    std::atomic<bool> pending_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
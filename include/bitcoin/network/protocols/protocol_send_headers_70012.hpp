@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_SEND_HEADERS_70012_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_SEND_HEADERS_70012_HPP
+
+#include <atomic>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/rolling_bloom_filter.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Headers announcement protocol (BIP130).
+ * Requests that the peer announce new blocks with headers and tracks the
+ * blocks known to the peer, setting the best known header on the channel.
+ * Blocks announced via p2p::announce(headers) are sent as headers when the
+ * peer requested it and the headers connect to a block known to the peer,
+ * otherwise the top block is announced by inventory.
+ * Attach this to a channel immediately following bip130 handshake completion.
+ */
+class BCT_API protocol_send_headers_70012
+  : public protocol_events, track<protocol_send_headers_70012>
+{
+public:
+    typedef std::shared_ptr<protocol_send_headers_70012> ptr;
+
+    /**
+     * Construct a send headers protocol instance.
+     * @param[in]  network   The network interface.
+     * @param[in]  channel   The channel on which to start the protocol.
+     */
+    protocol_send_headers_70012(p2p& network, channel::ptr channel);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+protected:
+    virtual bool handle_announce(const code& ec, headers_const_ptr message);
+    virtual bool handle_receive_send_headers(const code& ec,
+        send_headers_const_ptr message);
+    virtual bool handle_receive_headers(const code& ec,
+        headers_const_ptr message);
+    virtual bool handle_receive_inventory(const code& ec,
+        inventory_const_ptr message);
+
+    p2p& network_;
+    const channel::ptr channel_;
+
+private:
+    std::atomic<bool> headers_;
+
+    // These are protected by mutex.
+    rolling_bloom_filter known_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_PROTOCOL_TRANSACTION_DOWNLOAD_31402_HPP
+#define LIBBITCOIN_NETWORK_PROTOCOL_TRANSACTION_DOWNLOAD_31402_HPP
+
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/transaction_scheduler.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/**
+ * Transaction download protocol.
+ * Reports transaction announcements, deliveries and not found responses of
+ * the channel to the network transaction scheduler, and requests the
+ * transactions that the scheduler assigns to the channel.
+ * Attach this to a channel immediately following handshake completion.
+ */
+class BCT_API protocol_transaction_download_31402
+  : public protocol_events, track<protocol_transaction_download_31402>
+{
+public:
+    typedef std::shared_ptr<protocol_transaction_download_31402> ptr;
+
+    /**
+     * Construct a transaction download protocol instance.
+     * @param[in]  network   The network interface.
+     * @param[in]  channel   The channel on which to start the protocol.
+     */
+    protocol_transaction_download_31402(p2p& network, channel::ptr channel);
+
+    /**
+     * Start the protocol.
+     */
+    virtual void start();
+
+protected:
+    virtual void handle_stop(const code& ec);
+    virtual void send_requests(const hash_list& hashes);
+
+    virtual bool handle_receive_inventory(const code& ec,
+        inventory_const_ptr message);
+    virtual bool handle_receive_transaction(const code& ec,
+        transaction_const_ptr message);
+    virtual bool handle_receive_not_found(const code& ec,
+        not_found_const_ptr message);
+
+    p2p& network_;
+    const transaction_scheduler::ptr scheduler_;
+    const message::inventory_vector::type_id request_type_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
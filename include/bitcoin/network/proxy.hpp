@@ -19,29 +19,55 @@
 #ifndef LIBBITCOIN_NETWORK_PROXY_HPP
 #define LIBBITCOIN_NETWORK_PROXY_HPP
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/block_parser.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/message_subscriber.hpp>
 #include <bitcoin/network/settings.hpp>
+#include <bitcoin/network/upload_shaper.hpp>
 
 namespace libbitcoin {
 namespace network {
 
+/// Outbound message class, in order of precedence on the send queue.
+enum class send_priority
+{
+    /// Handshake, keepalive and negotiation messages.
+    control,
+
+    /// Inventory, address and request messages.
+    announcement,
+
+    /// Block, transaction and header responses.
+    bulk
+};
+
 /// Manages all socket communication, thread safe.
 class BCT_API proxy
   : public enable_shared_from_base<proxy>, noncopyable
 {
 public:
     typedef std::shared_ptr<proxy> ptr;
+    typedef std::shared_ptr<const data_chunk> data_ptr;
     typedef std::function<void(const code&)> result_handler;
     typedef subscriber<code> stop_subscriber;
+    typedef std::function<bool(const code&, header_const_ptr, size_t,
+        transaction_const_ptr)> block_stream_handler;
+    typedef resubscriber<code, header_const_ptr, size_t,
+        transaction_const_ptr> block_stream_subscriber;
+    typedef std::function<bool(const code&, const message::heading&,
+        data_ptr)> raw_handler;
+    typedef resubscriber<code, message::heading, data_ptr> raw_subscriber;
 
     /// Construct an instance.
     proxy(threadpool& pool, socket::ptr socket, const settings& settings);
@@ -49,20 +75,55 @@ public:
     /// Validate proxy stopped.
     ~proxy();
 
-    /// Send a message on the socket.
+    /// Get the send priority of the specified message command.
+    static send_priority classify(const std::string& command);
+
+    /// Send a message on the socket, with the priority of its command.
     template <class Message>
     void send(const Message& message, result_handler handler)
     {
+        send(message, classify(Message::command), handler);
+    }
+
+    /// Send a message on the socket with the specified priority.
+    template <class Message>
+    void send(const Message& message, send_priority priority,
+        result_handler handler)
+    {
+        sending(message);
         auto data = message::serialize(version_, message, protocol_magic_);
         const auto payload = std::make_shared<data_chunk>(std::move(data));
         const auto command = std::make_shared<std::string>(message.command);
+        enqueue(priority, command, {}, payload, handler);
+    }
 
-        // Sequential dispatch is required because write may occur in multiple
-        // asynchronous steps invoked on different threads, causing deadlocks.
-        dispatch_.lock(&proxy::do_send,
-            shared_from_this(), command, payload, handler);
+    /// Send a message that is already framed (heading and payload), such as
+    /// one serialized once for many channels, observing it as sent.
+    /// The framing must match the negotiated version and network magic.
+    template <class Message>
+    void send(const Message& message, data_ptr framed, result_handler handler)
+    {
+        sending(message);
+        send_raw(Message::command, framed, handler);
     }
 
+    /// Send a shared message that is already framed (heading and payload),
+    /// such as from message::serialize, without copying or rehashing it.
+    /// The framing must match the negotiated version and network magic.
+    virtual void send_raw(const std::string& command, data_ptr message,
+        result_handler handler);
+
+    /// Send a shared payload, framed by a heading with the given checksum,
+    /// without copying or rehashing the payload.
+    virtual void send_raw(const std::string& command, data_ptr payload,
+        uint32_t checksum, result_handler handler);
+
+    /// The number of messages of the priority awaiting send.
+    virtual size_t send_queue_depth(send_priority priority) const;
+
+    /// The number of bytes of the priority awaiting send.
+    virtual size_t send_queue_bytes(send_priority priority) const;
+
     /// Subscribe to messages of the specified type on the socket.
     template <class Message>
     void subscribe(message_handler<Message>&& handler)
@@ -71,9 +132,43 @@ public:
             std::forward<message_handler<Message>>(handler));
     }
 
+    /// Subscribe to transactions of blocks as they are parsed from the wire.
+    /// Effective only when block streaming is configured (see settings).
+    /// The full block is subsequently delivered to block subscribers.
+    virtual void subscribe_block_stream(block_stream_handler handler);
+
+    /// Subscribe to payloads of pass-through commands, which are delivered
+    /// unparsed (in place of message subscription) for verbatim forwarding.
+    /// Handlers are invoked on the read thread, blocking the peer.
+    virtual void subscribe_raw(raw_handler handler);
+
+    /// Enable or disable pass-through of payloads of the specified command.
+    virtual void set_pass_through(const std::string& command, bool enabled);
+
+    /// Determine if payloads of the specified command are passed through.
+    virtual bool pass_through(const std::string& command) const;
+
     /// Subscribe to the stop event.
     virtual void subscribe_stop(result_handler handler);
 
+    /// Deliver a block that was assembled from other messages (such as a
+    /// compact block) to the block subscribers of this socket.
+    virtual void deliver(block_const_ptr block);
+
+    /// Set the delivery policy for received messages of the specified type.
+    virtual void set_delivery_policy(message::message_type type,
+        delivery policy);
+
+    /// Set the threadpool for dedicated delivery, must outlive the proxy.
+    virtual void set_dedicated_pool(threadpool& pool);
+
+    /// Shape writes through the upload shaper, call before start.
+    virtual void set_upload_shaper(upload_shaper::ptr shaper);
+
+    /// Set the upload rate of this socket in bytes per second (zero is
+    /// unlimited), effective only if shaped.
+    virtual void set_upload_rate(size_t bytes_per_second);
+
     /// Get the authority of the far end of this socket.
     virtual const config::authority& authority() const;
 
@@ -91,6 +186,15 @@ public:
     virtual void stop(const code& ec);
 
 protected:
+    /// Observe a message as it is sent, such as to record peer knowledge.
+    template <class Message>
+    void sending(const Message&)
+    {
+    }
+
+    /// Observe headers as they are sent (such as in reply to get_headers).
+    virtual void sending(const message::headers& message);
+
     virtual bool stopped() const;
     virtual void signal_activity() = 0;
     virtual void handle_stopping() = 0;
@@ -99,7 +203,25 @@ private:
     typedef byte_source<data_chunk> payload_source;
     typedef boost::iostreams::stream<payload_source> payload_stream;
     typedef std::shared_ptr<std::string> command_ptr;
-    typedef std::shared_ptr<data_chunk> payload_ptr;
+    typedef data_ptr payload_ptr;
+
+    struct outbound
+    {
+        send_priority priority;
+        uint64_t sequence;
+        command_ptr command;
+        payload_ptr heading;
+        payload_ptr payload;
+        result_handler handler;
+
+        size_t size() const
+        {
+            return (heading ? heading->size() : 0) + payload->size();
+        }
+    };
+
+    typedef std::deque<outbound> send_queue;
+    static const size_t priorities = 3;
 
     static config::authority authority_factory(socket::ptr socket);
 
@@ -109,14 +231,31 @@ private:
     void read_heading();
     void handle_read_heading(const boost_code& ec, size_t payload_size);
 
+    bool retained(const message::heading& head) const;
     void read_payload(const message::heading& head);
     void handle_read_payload(const boost_code& ec, size_t,
         const message::heading& head);
+    void handle_pass_through(const message::heading& head);
 
-    void do_send(command_ptr command, payload_ptr payload,
-        result_handler handler);
-    void handle_send(const boost_code& ec, size_t bytes, command_ptr command,
-        payload_ptr payload, result_handler handler);
+    void read_block(const message::heading& head, block_parser::ptr parser);
+    void handle_read_block(const boost_code& ec, size_t,
+        const message::heading& head, block_parser::ptr parser);
+    void handle_block_transaction(header_const_ptr header, size_t index,
+        transaction_const_ptr transaction);
+
+    bool throttled();
+    message_subscriber::completion_handler track_delivery(size_t size);
+    void handle_delivered(size_t size);
+
+    void enqueue(send_priority priority, command_ptr command,
+        payload_ptr heading, payload_ptr payload, result_handler handler);
+    bool dequeue(outbound& out, bool& shape);
+    void clear_queue(const code& ec);
+
+    void do_send(outbound message, bool shape);
+    void handle_granted(const code& ec, outbound message);
+    void do_write(const code& ec, outbound message);
+    void handle_send(const boost_code& ec, size_t bytes, outbound message);
 
     const config::authority authority_;
 
@@ -127,14 +266,39 @@ private:
 
     // These are thread safe.
     std::atomic<bool> stopped_;
+    std::atomic<bool> paused_;
+    std::atomic<size_t> backlog_;
+    const uint32_t backlog_limit_;
     const uint32_t protocol_magic_;
     const size_t maximum_payload_;
     const bool validate_checksum_;
+    const bool stream_blocks_;
+    const bool retain_payloads_;
+    const bool prioritize_sends_;
     const bool verbose_;
     std::atomic<uint32_t> version_;
     message_subscriber message_subscriber_;
     stop_subscriber::ptr stop_subscriber_;
-    dispatcher dispatch_;
+    block_stream_subscriber::ptr block_stream_subscriber_;
+    raw_subscriber::ptr raw_subscriber_;
+
+    // These are protected by pass_through_mutex_.
+    std::set<std::string> pass_through_;
+    mutable shared_mutex pass_through_mutex_;
+
+    // These are protected by send_mutex_.
+    bool sending_;
+    bool shaping_;
+    bool granted_;
+    outbound held_;
+    uint64_t sequence_;
+    std::array<send_queue, priorities> send_queues_;
+    std::array<size_t, priorities> send_bytes_;
+    mutable shared_mutex send_mutex_;
+
+    // These are set before start.
+    upload_shaper::ptr shaper_;
+    upload_shaper::flow::ptr flow_;
 };
 
 } // namespace network
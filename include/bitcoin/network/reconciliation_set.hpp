@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_RECONCILIATION_SET_HPP
+#define LIBBITCOIN_NETWORK_RECONCILIATION_SET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/pin_sketch.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// The transactions to be reconciled with a peer (erlay), thread safe.
+/// Transactions are identified to the peer by 32 bit short ids, salted by
+/// both peers. A reconciliation moves the set to a snapshot, which is
+/// sketched for the peer and cleared upon completion of the reconciliation.
+class BCT_API reconciliation_set
+{
+public:
+    typedef std::shared_ptr<reconciliation_set> ptr;
+    typedef pin_sketch::elements short_ids;
+
+    /// The maximum number of transactions awaiting reconciliation.
+    static const size_t maximum_size;
+
+    /// Construct from the salts of both peers and the rate (0 to 1) at which
+    /// transactions are flooded to the peer instead of reconciled.
+    reconciliation_set(uint64_t local_salt, uint64_t remote_salt,
+        double flood_rate);
+
+    /// The short id of the transaction for the peer.
+    uint32_t short_id(const hash_digest& hash) const;
+
+    /// Determine if the transaction is flooded to the peer.
+    bool flood(const hash_digest& hash) const;
+
+    /// Add a transaction for reconciliation, false if the set is full.
+    bool insert(const hash_digest& hash);
+
+    /// The number of transactions awaiting reconciliation.
+    size_t size() const;
+
+    /// Begin a reconciliation, adding the set to the snapshot, and return
+    /// the number of transactions in the snapshot.
+    size_t snapshot();
+
+    /// Sketch the snapshot at the given capacity.
+    pin_sketch sketch(size_t capacity) const;
+
+    /// Complete the reconciliation, returning the snapshot transactions of
+    /// the short ids and the short ids not in the snapshot.
+    hash_list complete(const short_ids& ids, short_ids& out_missing);
+
+    /// Complete the reconciliation, returning all snapshot transactions.
+    hash_list complete();
+
+private:
+    typedef std::unordered_map<uint32_t, hash_digest> transactions;
+
+    const hash_digest salt_;
+    const uint64_t key0_;
+    const uint64_t key1_;
+    const uint64_t flood_threshold_;
+
+    // These are protected by mutex.
+    transactions set_;
+    transactions snapshot_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
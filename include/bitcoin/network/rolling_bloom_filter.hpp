@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_ROLLING_BLOOM_FILTER_HPP
+#define LIBBITCOIN_NETWORK_ROLLING_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// A bloom filter of hashes that forgets the oldest elements, not thread safe.
+/// Elements are inserted into the current of two generations, and when it is
+/// full it replaces the previous generation, which is discarded. At least the
+/// most recent elements (as constructed) are always retained.
+class BCT_API rolling_bloom_filter
+{
+public:
+    /// Construct a filter retaining the given number of recent elements with
+    /// up to the given false positive rate.
+    rolling_bloom_filter(size_t elements, double false_positive_rate);
+
+    /// Insert a hash into the current generation.
+    void insert(const hash_digest& hash);
+
+    /// Determine if the hash is (probably) in either generation.
+    bool contains(const hash_digest& hash) const;
+
+    /// Remove all elements.
+    void clear();
+
+private:
+    typedef std::vector<uint64_t> bits;
+
+    size_t position(const hash_digest& hash, size_t function) const;
+    bool contains(const bits& generation, const hash_digest& hash) const;
+
+    const size_t elements_;
+    const size_t functions_;
+    const size_t size_;
+    const uint64_t tweak_;
+
+    size_t count_;
+    bits current_;
+    bits previous_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
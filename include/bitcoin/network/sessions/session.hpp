@@ -126,6 +126,9 @@ protected:
     virtual size_t address_count() const;
     virtual size_t connection_count() const;
     virtual code fetch_address(address& out_address) const;
+    virtual code fetch_anchor(address& out_address);
+    virtual void store(const address::list& addresses,
+        result_handler handler);
     virtual bool blacklisted(const authority& authority) const;
     virtual bool stopped() const;
     virtual bool stopped(const code& ec) const;
@@ -136,6 +139,9 @@ protected:
     virtual acceptor::ptr create_acceptor();
     virtual connector::ptr create_connector();
 
+    /// The connect scheduler (backoff and timeout) shared by all connectors.
+    virtual connect_scheduler::ptr connect_attempts() const;
+
     // Pending connect.
     // ------------------------------------------------------------------------
 
@@ -168,6 +174,9 @@ protected:
     virtual void start_channel(channel::ptr channel,
         result_handler handle_started);
 
+    /// Override to set per message type delivery policy before channel start.
+    virtual void set_delivery_policy(channel::ptr channel);
+
     /// Override to attach specialized handshake protocols upon session start.
     virtual void attach_handshake_protocols(channel::ptr channel,
         result_handler handle_started);
@@ -176,6 +185,20 @@ protected:
     virtual void handshake_complete(channel::ptr channel,
         result_handler handle_started);
 
+    // Protocol attachment.
+    //-------------------------------------------------------------------------
+
+    /// Attach the ping protocol of the negotiated version.
+    virtual void attach_ping_protocols(channel::ptr channel);
+
+    /// Attach the relay protocols of the negotiated version. Addresses and
+    /// transactions are exchanged only with full relay. Sessions also differ
+    /// in whether they initiate reconciliation, download blocks and request
+    /// high bandwidth compact block relay.
+    virtual void attach_relay_protocols(channel::ptr channel, bool full_relay,
+        bool initiate_reconciliation, bool download_blocks,
+        bool high_bandwidth);
+
     // TODO: create session_timer base class.
     threadpool& pool_;
     const settings& settings_;
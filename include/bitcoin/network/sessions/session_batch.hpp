@@ -40,16 +40,24 @@ protected:
     /// Construct an instance.
     session_batch(p2p& network, bool notify_on_connect);
 
-    /// Create a channel from the configured number of concurrent attempts.
+    /// Create a channel from an anchor, if any remain, otherwise from the
+    /// configured number of concurrent attempts.
     virtual void connect(channel_handler handler);
 
+    /// Anchors are dialed by, and saved from, channels of the session.
+    virtual bool anchored() const;
+
 private:
     // Connect sequence
+    void connect_batch(channel_handler handler);
+    void handle_anchor(const code& ec, channel::ptr channel,
+        channel_handler handler);
     void new_connect(channel_handler handler);
     void start_connect(const code& ec, const authority& host,
         channel_handler handler);
     void handle_connect(const code& ec, channel::ptr channel,
-        connector::ptr connector, channel_handler handler);
+        const authority& host, connector::ptr connector,
+        channel_handler handler);
 
     const size_t batch_size_;
 };
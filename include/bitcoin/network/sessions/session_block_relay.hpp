@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_SESSION_BLOCK_RELAY_HPP
+#define LIBBITCOIN_NETWORK_SESSION_BLOCK_RELAY_HPP
+
+#include <cstddef>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/sessions/session_outbound.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+class p2p;
+
+/// Block-relay-only outbound connections session, thread safe.
+/// Channels handshake with relay=false and carry only headers and blocks, so
+/// neither addresses nor transactions are exchanged with these peers.
+class BCT_API session_block_relay
+  : public session_outbound, track<session_block_relay>
+{
+public:
+    typedef std::shared_ptr<session_block_relay> ptr;
+
+    /// Construct an instance.
+    session_block_relay(p2p& network, bool notify_on_connect);
+
+protected:
+    /// Overridden to attach only block relay protocols.
+    void attach_protocols(channel::ptr channel) override;
+
+    /// Overridden to maintain the configured block relay connection count.
+    size_t connection_target() const override;
+
+    /// Overridden to maintain no standby connections.
+    size_t standby_target() const override;
+
+    /// Overridden to disable transaction relay in the version message.
+    bool relay_transactions() const override;
+
+    /// Overridden to neither dial nor save anchors, which are full relay.
+    bool anchored() const override;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -20,7 +20,9 @@
 #define LIBBITCOIN_NETWORK_SESSION_OUTBOUND_HPP
 
 #include <cstddef>
+#include <deque>
 #include <memory>
+#include <set>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
 #include <bitcoin/network/define.hpp>
@@ -33,6 +35,12 @@ namespace network {
 class p2p;
 
 /// Outbound connections session, thread safe.
+/// With standby_connections, handshaked spare channels (running only the
+/// ping protocol) are maintained in addition to the target. A spare is
+/// promoted when an active channel stops, or when one expires, before it
+/// stops, so that the active count does not dip below the target. A spare
+/// handshakes as any other channel, but its relay protocols are not attached
+/// until promotion.
 class BCT_API session_outbound
   : public session_batch, track<session_outbound>
 {
@@ -54,9 +62,29 @@ protected:
     void attach_handshake_protocols(channel::ptr channel,
         result_handler handle_started) override;
 
-    /// Override to attach specialized protocols upon channel start.
+    /// Override to attach specialized protocols upon channel activation.
     virtual void attach_protocols(channel::ptr channel);
 
+    /// Override to attach protocols upon channel start, including standby.
+    virtual void attach_standby_protocols(channel::ptr channel);
+
+    /// The number of concurrent connections maintained by the session.
+    virtual size_t connection_target() const;
+
+    /// The number of standby connections maintained by the session.
+    virtual size_t standby_target() const;
+
+    /// The transaction relay preference announced in the version message.
+    virtual bool relay_transactions() const;
+
+    /// Add a started channel as active if below the connection target,
+    /// otherwise as standby, returning true if active.
+    bool admit(channel::ptr channel);
+
+    /// Retire the channel and, if it was active, promote a standby channel,
+    /// returning the promoted channel (or nullptr).
+    channel::ptr promote(channel::ptr channel);
+
 private:
     void new_connection(const code&);
 
@@ -68,6 +96,14 @@ private:
 
     void handle_channel_stop(const code& ec, channel::ptr channel);
     void handle_channel_start(const code& ec, channel::ptr channel);
+    void handle_channel_expiration(const code& ec, channel::ptr channel);
+
+    void activate(channel::ptr channel);
+
+    // These are protected by mutex.
+    std::set<channel::ptr> active_;
+    std::deque<channel::ptr> standby_;
+    mutable shared_mutex mutex_;
 };
 
 } // namespace network
@@ -35,6 +35,9 @@ namespace network {
 class p2p;
 
 /// Seed connections session, thread safe.
+/// With dns_seeding each seed is resolved and the address of each of its
+/// records is stored, with seed connections only if that does not yield an
+/// address for each configured outbound connection.
 class BCT_API session_seed
   : public session, track<session_seed>
 {
@@ -56,14 +59,32 @@ protected:
     virtual void attach_protocols(channel::ptr channel,
         result_handler handler);
 
+    /// Override to obtain the address records of a seed by other means,
+    /// passing them to store_resolved.
+    virtual void resolve_seed(const config::endpoint& seed,
+        result_handler handler);
+
+    /// Store the allowed address records of a seed.
+    void store_resolved(const message::network_address::list& addresses,
+        const config::endpoint& seed, result_handler handler);
+
 private:
     void start_seeding(size_t start_size, result_handler handler);
+    void start_resolving(size_t start_size, result_handler handler);
     void start_seed(const config::endpoint& seed, result_handler handler);
     void handle_started(const code& ec, result_handler handler);
     void handle_connect(const code& ec, channel::ptr channel,
         const config::endpoint& seed, connector::ptr connector,
         result_handler handler);
-    void handle_complete(size_t start_size, result_handler handler);
+    void handle_resolve(const code& ec,
+        const message::network_address::list& addresses,
+        const config::endpoint& seed, connector::ptr connector,
+        result_handler handler);
+    void handle_seeded(const code& ec, size_t start_size,
+        result_handler handler);
+    void handle_complete(const code& ec, result_handler handler);
+    void handle_resolved(const code& ec, size_t start_size,
+        result_handler handler);
 
     void handle_channel_start(const code& ec, channel::ptr channel,
         result_handler handler);
@@ -36,16 +36,40 @@ public:
 
     /// Properties.
     uint32_t threads;
+    uint32_t dedicated_threads;
     uint32_t protocol_maximum;
     uint32_t protocol_minimum;
     uint64_t services;
     uint64_t invalid_services;
     bool relay_transactions;
+    bool schedule_transactions;
+    uint32_t transaction_request_limit;
+    uint32_t transaction_request_timeout_seconds;
+    bool schedule_blocks;
+    uint32_t block_download_window;
+    uint32_t block_request_limit;
+    uint32_t block_request_timeout_seconds;
+    uint32_t block_stall_seconds;
+    bool send_headers;
+    bool compact_blocks;
+    bool compact_blocks_high_bandwidth;
+    uint32_t bloom_filter_budget_milliseconds;
+    bool reconcile_transactions;
+    uint32_t reconciliation_interval_seconds;
+    uint32_t reconciliation_fanout;
     bool validate_checksum;
+    bool stream_blocks;
+    bool retain_payloads;
+    uint32_t read_backlog_limit;
+    bool prioritize_sends;
+    uint32_t upload_kilobytes_per_second;
+    uint32_t peer_upload_kilobytes_per_second;
     uint32_t identifier;
     uint16_t inbound_port;
     uint32_t inbound_connections;
     uint32_t outbound_connections;
+    uint32_t block_relay_connections;
+    uint32_t standby_connections;
     uint32_t manual_attempt_limit;
     uint32_t connect_batch_size;
     uint32_t connect_timeout_seconds;
@@ -54,8 +78,12 @@ public:
     uint32_t channel_inactivity_minutes;
     uint32_t channel_expiration_minutes;
     uint32_t channel_germination_seconds;
+    uint32_t channel_trickle_milliseconds;
     uint32_t host_pool_capacity;
+    bool dns_seeding;
     boost::filesystem::path hosts_file;
+    uint32_t anchor_connections;
+    boost::filesystem::path anchors_file;
     config::authority self;
     config::authority::list blacklists;
     config::endpoint::list peers;
@@ -80,6 +108,12 @@ public:
     asio::duration channel_inactivity() const;
     asio::duration channel_expiration() const;
     asio::duration channel_germination() const;
+    asio::duration channel_trickle() const;
+    asio::duration transaction_request_timeout() const;
+    asio::duration block_request_timeout() const;
+    asio::duration block_stall_timeout() const;
+    asio::duration bloom_filter_budget() const;
+    asio::duration reconciliation_interval() const;
 };
 
 } // namespace network
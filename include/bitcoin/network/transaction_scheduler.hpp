@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_TRANSACTION_SCHEDULER_HPP
+#define LIBBITCOIN_NETWORK_TRANSACTION_SCHEDULER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/rolling_bloom_filter.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Schedules transaction downloads across channels, thread safe.
+/// Each announced transaction is requested from only one of the peers that
+/// announced it, subject to a limit of requests in flight per peer. If that
+/// peer disconnects, responds not found, or does not respond in time, the
+/// transaction is requested from the next announcing peer.
+class BCT_API transaction_scheduler
+  : public enable_shared_from_base<transaction_scheduler>, noncopyable
+{
+public:
+    typedef std::shared_ptr<transaction_scheduler> ptr;
+    typedef std::function<void(const hash_list&)> request_handler;
+    typedef std::function<bool(const hash_digest&)> filter_handler;
+
+    /// Construct an instance.
+    transaction_scheduler(threadpool& pool, const settings& settings);
+
+    /// Start the timeout timer.
+    virtual void start();
+
+    /// Stop the timeout timer and clear all state.
+    virtual void stop();
+
+    /// Set the predicate by which announced transactions are wanted, such as
+    /// not already pooled. The predicate is not invoked under lock.
+    virtual void set_filter(filter_handler filter);
+
+    /// Register a peer, with the handler by which to request from it.
+    virtual void connect(uint64_t peer, request_handler handler);
+
+    /// Unregister a peer, requesting its in-flight transactions elsewhere.
+    virtual void disconnect(uint64_t peer);
+
+    /// The peer announced the transactions.
+    virtual void announced(uint64_t peer, const hash_list& hashes);
+
+    /// The peer delivered the transaction.
+    virtual void received(uint64_t peer, const hash_digest& hash);
+
+    /// The peer does not have the transactions.
+    virtual void not_found(uint64_t peer, const hash_list& hashes);
+
+    /// The number of transactions requested from the peer and outstanding.
+    virtual size_t in_flight(uint64_t peer) const;
+
+    /// The number of announced transactions not yet received.
+    virtual size_t announcements() const;
+
+private:
+    typedef std::map<uint64_t, hash_list> requests;
+
+    // Announcers not yet requested from, in order of announcement.
+    struct entry
+    {
+        std::deque<uint64_t> candidates;
+        bool assigned;
+        uint64_t requested;
+        asio::time_point expiry;
+    };
+
+    // Waiting transactions are unassigned, awaiting capacity of the peer.
+    struct peer
+    {
+        request_handler handler;
+        size_t in_flight;
+        size_t announced;
+        std::set<hash_digest> waiting;
+    };
+
+    bool available(uint64_t peer) const;
+    void schedule(const hash_digest& hash, entry& item, requests& out);
+    void assign(const hash_digest& hash, entry& item, uint64_t peer,
+        requests& out);
+    void fill(uint64_t peer, requests& out);
+    void release(entry& item);
+    void erase(const hash_digest& hash, requests& out);
+    void send(const requests& out) const;
+
+    void start_timer();
+    void handle_timer(const code& ec);
+
+    // These are thread safe.
+    std::atomic<bool> stopped_;
+    const size_t limit_;
+    const asio::duration timeout_;
+    const deadline::ptr timer_;
+
+    // These are protected by mutex.
+    filter_handler filter_;
+    std::map<hash_digest, entry> entries_;
+    std::map<uint64_t, peer> peers_;
+    rolling_bloom_filter received_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
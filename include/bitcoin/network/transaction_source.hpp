@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_TRANSACTION_SOURCE_HPP
+#define LIBBITCOIN_NETWORK_TRANSACTION_SOURCE_HPP
+
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Interface to the transactions that may appear in new blocks (such as a
+/// transaction pool), for the reconstruction of compact blocks. Implement
+/// this in the node and set it on the network (see p2p).
+class BCT_API transaction_source
+{
+public:
+    typedef std::shared_ptr<transaction_source> ptr;
+    typedef std::vector<transaction_const_ptr> list;
+
+    virtual ~transaction_source() {}
+
+    /// Get a snapshot of the candidate transactions, must be thread safe.
+    virtual list transactions() const = 0;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
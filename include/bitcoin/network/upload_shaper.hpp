@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_UPLOAD_SHAPER_HPP
+#define LIBBITCOIN_NETWORK_UPLOAD_SHAPER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// Upload rate limiting across channels, thread safe.
+/// Each channel writes through a flow with its own token bucket, and all
+/// flows draw from a global token bucket. Backlogged flows are served by
+/// deficit round robin, so no one channel can monopolize the global rate.
+/// A rate of zero is unlimited. Exempt writes are charged but not delayed.
+/// The refill timer runs only while some rate is limited.
+class BCT_API upload_shaper
+  : public enable_shared_from_base<upload_shaper>, noncopyable
+{
+public:
+    typedef std::shared_ptr<upload_shaper> ptr;
+    typedef std::function<void(const code&)> result_handler;
+
+    /// The shaping state of one channel, protected by the shaper.
+    struct flow
+    {
+        typedef std::shared_ptr<flow> ptr;
+        typedef std::pair<size_t, result_handler> request;
+
+        size_t rate;
+        int64_t tokens;
+        int64_t deficit;
+        std::deque<request> pending;
+    };
+
+    /// Construct an instance.
+    upload_shaper(threadpool& pool, const settings& settings);
+
+    /// Start the refill timer, if any rate is limited.
+    virtual void start();
+
+    /// Stop the refill timer and fail all pending requests.
+    virtual void stop();
+
+    /// Open a flow at the configured per channel rate.
+    virtual flow::ptr open();
+
+    /// Close a flow, failing its pending requests.
+    virtual void close(flow::ptr flow);
+
+    /// Invoke the handler once bytes may be written on the flow.
+    virtual void request(flow::ptr flow, size_t bytes, bool exempt,
+        result_handler handler);
+
+    /// The global rate in bytes per second.
+    virtual size_t rate() const;
+
+    /// Set the global rate in bytes per second.
+    virtual void set_rate(size_t bytes_per_second);
+
+    /// The rate of the flow in bytes per second.
+    virtual size_t rate(flow::ptr flow) const;
+
+    /// Set the rate of the flow in bytes per second.
+    virtual void set_rate(flow::ptr flow, size_t bytes_per_second);
+
+private:
+    typedef std::vector<flow::request> grants;
+
+    static bool available(size_t rate, int64_t tokens);
+    static void charge(size_t rate, int64_t& tokens, size_t bytes);
+    static void refill(size_t rate, int64_t& tokens);
+
+    bool limited() const;
+    bool claim_timer();
+    void start_timer();
+    void handle_timer(const code& ec);
+    void schedule(grants& out);
+    void fail(grants& out, const code& ec);
+
+    // This is thread safe.
+    std::atomic<bool> stopped_;
+    const deadline::ptr timer_;
+    const size_t peer_rate_;
+
+    // These are protected by mutex.
+    bool timing_;
+    size_t rate_;
+    int64_t tokens_;
+    std::set<flow::ptr> flows_;
+    std::list<flow::ptr> active_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NETWORK_WIRE_PAYLOAD_HPP
+#define LIBBITCOIN_NETWORK_WIRE_PAYLOAD_HPP
+
+#include <cstdint>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+/// The original payload bytes of a received message, verified against the
+/// heading checksum. The hash is the bitcoin hash of the payload, so for a
+/// transaction without witness it is the transaction hash.
+struct wire_payload
+{
+    typedef std::shared_ptr<const data_chunk> data_ptr;
+
+    data_ptr data;
+    hash_digest hash;
+
+    /// The heading checksum of the payload.
+    uint32_t checksum() const
+    {
+        return from_little_endian_unsafe<uint32_t>(hash.begin());
+    }
+};
+
+/// Deleter of a received message that also owns its wire payload.
+template <class Message>
+class wire_deleter
+{
+public:
+    wire_deleter(const wire_payload& payload)
+      : payload_(payload)
+    {
+    }
+
+    void operator()(Message* message) const
+    {
+        delete message;
+    }
+
+    const wire_payload& payload() const
+    {
+        return payload_;
+    }
+
+private:
+    wire_payload payload_;
+};
+
+/// Get the wire payload retained by a received message, or nullptr if not
+/// retained (see settings.retain_payloads). Valid while the message is held.
+/// Relay with proxy::send_raw(command, payload->data, payload->checksum()).
+template <class Message>
+const wire_payload* get_wire_payload(
+    const std::shared_ptr<const Message>& message)
+{
+    const auto deleter = std::get_deleter<wire_deleter<Message>>(message);
+    return deleter == nullptr ? nullptr : &deleter->payload();
+}
+
+} // namespace network
+} // namespace libbitcoin
+
+#endif
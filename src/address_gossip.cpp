@@ -0,0 +1,258 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/address_gossip.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/hosts.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "address_gossip"
+
+using namespace std::placeholders;
+
+// Each drain holds the host pool lock for no more than one batch.
+static const size_t store_batch = 100;
+
+// Bound the queue (to bound memory), later addresses are dropped.
+static const size_t maximum_queued = 10 * max_address;
+
+// Addresses are relayed only if timestamped within the last ten minutes.
+static const uint32_t fresh_seconds = 10 * 60;
+
+// An address is relayed once for at least the most recent 10000 selected.
+static const size_t recent_relayed = 10000;
+static const double relayed_false_positive_rate = 0.000001;
+
+// A sample is reused for a randomized window of about six hours, so that
+// repeated get_address requests cannot map the host pool.
+static const asio::hours sample_window(6);
+
+// A sample is no more than this percentage of the host pool (or max_address).
+static const size_t sample_percentage = 23;
+
+static hash_digest identify(const message::network_address& host)
+{
+    return sha256_hash(build_chunk({ host.ip(),
+        to_little_endian(host.port()) }));
+}
+
+address_gossip::address_gossip(threadpool& pool, hosts& hosts)
+  : stopped_(true),
+    hosts_(hosts),
+    dispatch_(pool, NAME),
+    draining_(false),
+    relayed_(recent_relayed, relayed_false_positive_rate)
+{
+}
+
+// Start/Stop.
+// ----------------------------------------------------------------------------
+
+void address_gossip::start()
+{
+    stopped_ = false;
+}
+
+void address_gossip::stop()
+{
+    stopped_ = true;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    queue_.clear();
+    relayed_.clear();
+    sample_.reset();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Storage.
+// ----------------------------------------------------------------------------
+
+void address_gossip::store(const address::list& addresses)
+{
+    if (stopped_ || addresses.empty())
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto space = maximum_queued - std::min(queue_.size(),
+        maximum_queued);
+    const auto count = std::min(space, addresses.size());
+    queue_.insert(queue_.end(), addresses.begin(), addresses.begin() + count);
+
+    const auto start = !draining_ && !queue_.empty();
+    draining_ = draining_ || start;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (count < addresses.size())
+        LOG_DEBUG(LOG_NETWORK)
+            << "Dropped (" << addresses.size() - count
+            << ") addresses in excess of the gossip queue limit.";
+
+    if (start)
+        dispatch_.concurrent(
+            std::bind(&address_gossip::drain,
+                shared_from_this()));
+}
+
+// Each batch is stored on a new thread, so that draining a large queue does
+// not hold a pool thread (or the host pool lock) for its entire duration.
+void address_gossip::drain()
+{
+    address::list batch;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto count = std::min(queue_.size(), store_batch);
+    batch.assign(queue_.begin(), queue_.begin() + count);
+    queue_.erase(queue_.begin(), queue_.begin() + count);
+
+    const auto more = !stopped_ && !queue_.empty();
+    draining_ = more;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!batch.empty() && !stopped_)
+        hosts_.store(batch,
+            std::bind(&address_gossip::handle_store,
+                shared_from_this(), _1));
+
+    if (more)
+        dispatch_.concurrent(
+            std::bind(&address_gossip::drain,
+                shared_from_this()));
+}
+
+void address_gossip::handle_store(const code& ec)
+{
+    if (ec && ec != error::service_stopped)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure storing gossiped addresses: " << ec.message();
+}
+
+size_t address_gossip::queued() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return queue_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Sample.
+// ----------------------------------------------------------------------------
+
+// The host pool is locked and copied once per window, not once per request.
+// An empty sample is not cached, as the pool may be populating.
+address_const_ptr address_gossip::sample()
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+
+    if (sample_ && now < expiry_)
+    {
+        const auto cached = sample_;
+        mutex_.unlock_shared();
+        //---------------------------------------------------------------------
+        return cached;
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto portion = hosts_.count() * sample_percentage / 100;
+    const auto count = std::min(std::max(portion, size_t(1)), max_address);
+    const auto sampled = std::make_shared<const message::address>(
+        hosts_.sample(count));
+
+    if (sampled->addresses().empty())
+        return sampled;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // Another thread may have refreshed the sample concurrently.
+    if (!sample_ || now >= expiry_)
+    {
+        sample_ = sampled;
+        expiry_ = now + pseudo_randomize(sample_window);
+    }
+
+    return sample_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Relay.
+// ----------------------------------------------------------------------------
+
+address_gossip::address::list address_gossip::relayable(
+    const address::list& addresses)
+{
+    address::list out;
+
+    if (stopped_)
+        return out;
+
+    const auto now = static_cast<uint32_t>(zulu_time());
+    const auto horizon = now - std::min(now, fresh_seconds);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    for (const auto& host: addresses)
+    {
+        if (!host.is_valid() || host.timestamp() < horizon)
+            continue;
+
+        const auto hash = identify(host);
+
+        if (relayed_.contains(hash))
+            continue;
+
+        relayed_.insert(hash);
+        out.push_back(host);
+    }
+
+    return out;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace network
+} // namespace libbitcoin
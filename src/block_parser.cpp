@@ -0,0 +1,404 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/block_parser.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/define.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::message;
+
+// Version, input count, output count and locktime, used only to bound count.
+static const size_t minimum_transaction_size = 10;
+
+// The witness marker takes the place of the input count (bip144).
+static const uint8_t witness_marker = 0x00;
+static const size_t witness_marker_size = 2;
+
+block_parser::block_parser(size_t payload_size, transaction_handler handler)
+  : payload_size_(payload_size),
+    handler_(handler),
+    state_(state::header),
+    written_(0),
+    count_(0),
+    offset_(0),
+    field_(field::version),
+    measured_(0),
+    length_(0),
+    inputs_(0),
+    remaining_(0),
+    items_(0),
+    witness_(false)
+{
+}
+
+size_t block_parser::remaining() const
+{
+    return payload_size_ - written_;
+}
+
+bool block_parser::complete() const
+{
+    return state_ == state::done && remaining() == 0 &&
+        offset_ == buffer_.size();
+}
+
+code block_parser::write(const data_chunk& data)
+{
+    if (state_ == state::invalid || data.size() > remaining())
+        return error::bad_stream;
+
+    written_ += data.size();
+    extend_data(buffer_, data);
+
+    if (state_ == state::header && parse_header())
+        state_ = state::count;
+
+    if (state_ == state::count && parse_count())
+        state_ = state::transactions;
+
+    if (state_ == state::transactions && parse_transactions())
+        state_ = state::done;
+
+    if (state_ == state::invalid)
+        return error::bad_stream;
+
+    compact();
+
+    // A complete payload must be fully parsed and consumed.
+    if (remaining() == 0 && !complete())
+        return error::bad_stream;
+
+    // Bytes beyond the last transaction are invalid.
+    if (state_ == state::done && offset_ != buffer_.size())
+        return error::bad_stream;
+
+    return error::success;
+}
+
+// Buffer management.
+// ----------------------------------------------------------------------------
+
+// The number of buffered bytes beyond the measured part of the transaction.
+size_t block_parser::available() const
+{
+    return buffer_.size() - offset_ - measured_;
+}
+
+// Parsed bytes are dropped only once they are the larger part of the buffer,
+// so each byte is moved at most a constant number of times.
+void block_parser::compact()
+{
+    if (offset_ == buffer_.size())
+    {
+        buffer_.clear();
+        offset_ = 0;
+        return;
+    }
+
+    if (offset_ <= buffer_.size() / 2)
+        return;
+
+    buffer_.erase(buffer_.begin(), buffer_.begin() + offset_);
+    offset_ = 0;
+}
+
+bool block_parser::skip(uint64_t size)
+{
+    if (available() < size)
+        return false;
+
+    measured_ += static_cast<size_t>(size);
+    return true;
+}
+
+bool block_parser::read_size(uint64_t& value)
+{
+    if (available() == 0)
+        return false;
+
+    const auto position = offset_ + measured_;
+    const auto prefix = buffer_[position];
+    const size_t size = prefix < 0xfd ? 1 : prefix == 0xfd ? 3 :
+        prefix == 0xfe ? 5 : 9;
+
+    if (available() < size)
+        return false;
+
+    value = prefix;
+
+    if (size > 1)
+    {
+        value = 0;
+
+        // Little endian, following the prefix byte.
+        for (auto byte = size - 1; byte > 0; --byte)
+            value = (value << 8) | buffer_[position + byte];
+    }
+
+    measured_ += size;
+    return true;
+}
+
+// Advance the measurement of the transaction at offset_ as far as the buffer
+// allows, returning true once its full length is known. Measured fields are
+// not revisited, so a transaction spread over many writes is scanned once.
+bool block_parser::measure()
+{
+    while (true)
+    {
+        switch (field_)
+        {
+            case field::version:
+            {
+                if (!skip(sizeof(uint32_t)))
+                    return false;
+
+                field_ = field::marker;
+                break;
+            }
+            case field::marker:
+            {
+                if (available() == 0)
+                    return false;
+
+                witness_ = buffer_[offset_ + measured_] == witness_marker;
+
+                if (witness_ && !skip(witness_marker_size))
+                    return false;
+
+                field_ = field::input_count;
+                break;
+            }
+            case field::input_count:
+            {
+                if (!read_size(inputs_))
+                    return false;
+
+                remaining_ = inputs_;
+                field_ = remaining_ == 0 ? field::output_count :
+                    field::input_point;
+                break;
+            }
+            case field::input_point:
+            {
+                if (!skip(chain::point::satoshi_fixed_size()))
+                    return false;
+
+                field_ = field::input_script_size;
+                break;
+            }
+            case field::input_script_size:
+            {
+                if (!read_size(length_))
+                    return false;
+
+                field_ = field::input_script;
+                break;
+            }
+            case field::input_script:
+            {
+                if (!skip(length_))
+                    return false;
+
+                field_ = field::input_sequence;
+                break;
+            }
+            case field::input_sequence:
+            {
+                if (!skip(sizeof(uint32_t)))
+                    return false;
+
+                field_ = --remaining_ == 0 ? field::output_count :
+                    field::input_point;
+                break;
+            }
+            case field::output_count:
+            {
+                if (!read_size(remaining_))
+                    return false;
+
+                field_ = remaining_ != 0 ? field::output_value :
+                    witness_ && inputs_ != 0 ? field::witness_count :
+                    field::locktime;
+
+                if (field_ == field::witness_count)
+                    remaining_ = inputs_;
+
+                break;
+            }
+            case field::output_value:
+            {
+                if (!skip(sizeof(uint64_t)))
+                    return false;
+
+                field_ = field::output_script_size;
+                break;
+            }
+            case field::output_script_size:
+            {
+                if (!read_size(length_))
+                    return false;
+
+                field_ = field::output_script;
+                break;
+            }
+            case field::output_script:
+            {
+                if (!skip(length_))
+                    return false;
+
+                if (--remaining_ != 0)
+                {
+                    field_ = field::output_value;
+                    break;
+                }
+
+                field_ = witness_ && inputs_ != 0 ? field::witness_count :
+                    field::locktime;
+                remaining_ = inputs_;
+                break;
+            }
+            case field::witness_count:
+            {
+                if (!read_size(items_))
+                    return false;
+
+                field_ = items_ != 0 ? field::witness_size :
+                    --remaining_ == 0 ? field::locktime :
+                    field::witness_count;
+                break;
+            }
+            case field::witness_size:
+            {
+                if (!read_size(length_))
+                    return false;
+
+                field_ = field::witness;
+                break;
+            }
+            case field::witness:
+            {
+                if (!skip(length_))
+                    return false;
+
+                field_ = --items_ != 0 ? field::witness_size :
+                    --remaining_ == 0 ? field::locktime :
+                    field::witness_count;
+                break;
+            }
+            case field::locktime:
+            {
+                return skip(sizeof(uint32_t));
+            }
+        }
+    }
+}
+
+// Parsers.
+// ----------------------------------------------------------------------------
+
+bool block_parser::parse_header()
+{
+    const auto size = chain::header::satoshi_fixed_size();
+
+    if (available() < size)
+        return false;
+
+    const auto begin = buffer_.begin() + offset_;
+
+    if (!header_.from_data(data_chunk{ begin, begin + size }))
+    {
+        state_ = state::invalid;
+        return false;
+    }
+
+    offset_ += size;
+    header_ptr_ = std::make_shared<message::header>(header_);
+    return true;
+}
+
+bool block_parser::parse_count()
+{
+    if (!read_size(count_))
+        return false;
+
+    offset_ += measured_;
+    measured_ = 0;
+
+    // Guard the reservation against a count that the payload cannot satisfy.
+    if (count_ > payload_size_ / minimum_transaction_size)
+    {
+        state_ = state::invalid;
+        return false;
+    }
+
+    transactions_.reserve(static_cast<size_t>(count_));
+    return true;
+}
+
+bool block_parser::parse_transactions()
+{
+    while (transactions_.size() < count_)
+    {
+        if (!measure())
+            return false;
+
+        const auto begin = buffer_.begin() + offset_;
+        const data_chunk data{ begin, begin + measured_ };
+        chain::transaction transaction;
+
+        // Witness is deserialized if present, as with message::block.
+        if (!transaction.from_data(data, true, true) ||
+            transaction.serialized_size(true, true) != measured_)
+        {
+            state_ = state::invalid;
+            return false;
+        }
+
+        offset_ += measured_;
+        measured_ = 0;
+        field_ = field::version;
+        const auto index = transactions_.size();
+
+        if (handler_)
+            handler_(header_ptr_, index,
+                std::make_shared<message::transaction>(transaction));
+
+        transactions_.push_back(std::move(transaction));
+    }
+
+    return true;
+}
+
+block_const_ptr block_parser::finish()
+{
+    BITCOIN_ASSERT_MSG(complete(), "The block is not complete.");
+    return std::make_shared<message::block>(std::move(header_),
+        std::move(transactions_));
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,473 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/block_scheduler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::placeholders;
+
+// Timeouts and stalls are checked once per second.
+static const asio::seconds timer_interval(1);
+
+// Weight of the most recent delivery in the throughput average.
+static const double rate_weight = 0.25;
+
+block_scheduler::block_scheduler(threadpool& pool, const settings& settings)
+  : stopped_(true),
+    window_(settings.block_download_window),
+    limit_(settings.block_request_limit),
+    timeout_(settings.block_request_timeout()),
+    stall_(settings.block_stall_timeout()),
+    timer_(std::make_shared<deadline>(pool, timer_interval)),
+    outstanding_(0)
+{
+}
+
+// Start/Stop.
+// ----------------------------------------------------------------------------
+
+void block_scheduler::start()
+{
+    stopped_ = false;
+    start_timer();
+}
+
+void block_scheduler::stop()
+{
+    stopped_ = true;
+    timer_->stop();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    outstanding_ = 0;
+    order_.clear();
+    entries_.clear();
+    peers_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Work.
+// ----------------------------------------------------------------------------
+
+void block_scheduler::enqueue(const hash_list& hashes)
+{
+    if (stopped_)
+        return;
+
+    requests out;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& hash: hashes)
+    {
+        if (entries_.find(hash) != entries_.end())
+            continue;
+
+        entries_[hash] = { 0, {}, false, {} };
+        order_.push_back(hash);
+        ++outstanding_;
+    }
+
+    schedule(out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+// Peers.
+// ----------------------------------------------------------------------------
+
+void block_scheduler::connect(uint64_t peer, request_handler request,
+    result_handler stop)
+{
+    if (stopped_)
+        return;
+
+    requests out;
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    peers_[peer] = { request, stop, 0, 0.0, now };
+    schedule(out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+void block_scheduler::disconnect(uint64_t peer)
+{
+    requests out;
+    stops stopped;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    remove(peer, stopped);
+    schedule(out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+// Events.
+// ----------------------------------------------------------------------------
+
+void block_scheduler::received(uint64_t peer, const hash_digest& hash,
+    size_t size)
+{
+    requests out;
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto it = entries_.find(hash);
+
+    if (it == entries_.end() || it->second.received)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    auto& item = it->second;
+    const auto deliverer = peers_.find(peer);
+
+    // Time the delivery from the later of its request and the prior delivery.
+    if (deliverer != peers_.end() && item.requested == peer)
+    {
+        auto& state = deliverer->second;
+        const auto start = std::max(item.time, state.last);
+        const auto elapsed = std::chrono::duration_cast<
+            std::chrono::duration<double>>(now - start).count();
+
+        if (elapsed > 0)
+        {
+            const auto rate = size / elapsed;
+            state.rate = state.rate == 0.0 ? rate :
+                (1.0 - rate_weight) * state.rate + rate_weight * rate;
+        }
+
+        state.last = now;
+    }
+
+    release(item);
+    item.received = true;
+    --outstanding_;
+    advance();
+    schedule(out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+void block_scheduler::not_found(uint64_t peer, const hash_list& hashes)
+{
+    requests out;
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& hash: hashes)
+    {
+        const auto it = entries_.find(hash);
+
+        if (it == entries_.end() || it->second.requested != peer)
+            continue;
+
+        release(it->second);
+        it->second.excluded.insert(peer);
+        it->second.time = now;
+    }
+
+    schedule(out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+// Properties.
+// ----------------------------------------------------------------------------
+
+size_t block_scheduler::in_flight(uint64_t peer) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = peers_.find(peer);
+    return it == peers_.end() ? 0 : it->second.in_flight;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+double block_scheduler::throughput(uint64_t peer) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = peers_.find(peer);
+    return it == peers_.end() ? 0.0 : it->second.rate;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_scheduler::pending() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return outstanding_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Scheduling (must be called under lock).
+// ----------------------------------------------------------------------------
+
+// Free the request slot of the peer from which the item was requested.
+void block_scheduler::release(entry& item)
+{
+    const auto it = peers_.find(item.requested);
+
+    if (it != peers_.end() && it->second.in_flight > 0)
+        --it->second.in_flight;
+
+    item.requested = 0;
+}
+
+// Unregister the peer, returning its stop handler, and release its blocks.
+void block_scheduler::remove(uint64_t peer, stops& out)
+{
+    const auto it = peers_.find(peer);
+
+    if (it == peers_.end())
+        return;
+
+    out[peer] = it->second.stop;
+    peers_.erase(it);
+
+    for (auto& entry: entries_)
+        if (entry.second.requested == peer)
+            entry.second.requested = 0;
+}
+
+// Peers may obtain a block after reporting it not found. So once all current
+// peers have excluded a block, the exclusions are cleared after the request
+// timeout (from the last exclusion), and the block is requested again.
+void block_scheduler::readmit(const asio::time_point& now)
+{
+    for (auto& entry: entries_)
+    {
+        auto& item = entry.second;
+
+        if (item.received || item.requested != 0 || item.excluded.empty() ||
+            now - item.time <= timeout_)
+            continue;
+
+        auto excluded = true;
+
+        for (const auto& connected: peers_)
+            excluded = excluded &&
+                item.excluded.find(connected.first) != item.excluded.end();
+
+        if (excluded)
+            item.excluded.clear();
+    }
+}
+
+// Drop received blocks from the front of the window.
+void block_scheduler::advance()
+{
+    while (!order_.empty() && entries_[order_.front()].received)
+    {
+        entries_.erase(order_.front());
+        order_.pop_front();
+    }
+}
+
+// Assign unrequested blocks within the window, in order, each to the peer of
+// highest throughput with capacity. New peers (no measured rate) are tried
+// after measured peers, so each peer is measured as capacity permits.
+void block_scheduler::schedule(requests& out)
+{
+    if (peers_.empty())
+        return;
+
+    const auto now = asio::steady_clock::now();
+    const auto end = order_.begin() + std::min(window_, order_.size());
+
+    for (auto hash = order_.begin(); hash != end; ++hash)
+    {
+        auto& item = entries_[*hash];
+
+        if (item.received || item.requested != 0)
+            continue;
+
+        auto best = peers_.end();
+
+        for (auto it = peers_.begin(); it != peers_.end(); ++it)
+        {
+            if (it->second.in_flight >= limit_ ||
+                item.excluded.find(it->first) != item.excluded.end())
+                continue;
+
+            if (best == peers_.end() || it->second.rate > best->second.rate)
+                best = it;
+        }
+
+        // Each block after this faces the same or fewer available peers,
+        // unless excluded, so continue for those with exclusions.
+        if (best == peers_.end())
+            continue;
+
+        ++best->second.in_flight;
+        item.requested = best->first;
+        item.time = now;
+        out[best->first].push_back(*hash);
+    }
+}
+
+void block_scheduler::send(const requests& out) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+
+    std::vector<std::pair<request_handler, hash_list>> sends;
+
+    for (const auto& request: out)
+    {
+        const auto it = peers_.find(request.first);
+
+        if (it != peers_.end())
+            sends.push_back({ it->second.request, request.second });
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& request: sends)
+        request.first(request.second);
+}
+
+// Timer.
+// ----------------------------------------------------------------------------
+
+void block_scheduler::start_timer()
+{
+    if (stopped_)
+        return;
+
+    timer_->start(
+        std::bind(&block_scheduler::handle_timer,
+            shared_from_this(), _1));
+}
+
+// A peer that holds a block past the request timeout is stopped. A peer that
+// holds the earliest outstanding block past the stall timeout, while later
+// blocks in the window have been received, is stalling the window and is
+// also stopped. The blocks of stopped peers are assigned to other peers.
+void block_scheduler::handle_timer(const code&)
+{
+    if (stopped_)
+        return;
+
+    requests out;
+    stops stopped;
+    std::set<uint64_t> slow;
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& entry: entries_)
+        if (entry.second.requested != 0 && now - entry.second.time > timeout_)
+            slow.insert(entry.second.requested);
+
+    if (!order_.empty())
+    {
+        const auto& front = entries_[order_.front()];
+        const auto end = order_.begin() + std::min(window_, order_.size());
+        const auto progress = std::any_of(order_.begin(), end,
+            [this](const hash_digest& hash)
+            {
+                return entries_[hash].received;
+            });
+
+        if (front.requested != 0 && progress && now - front.time > stall_)
+            slow.insert(front.requested);
+    }
+
+    for (const auto peer: slow)
+        remove(peer, stopped);
+
+    readmit(now);
+    schedule(out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& stop: stopped)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Stopping slow block download peer (" << stop.first << ")";
+
+        stop.second(error::channel_timeout);
+    }
+
+    send(out);
+    start_timer();
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,311 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/bloom_filter.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace bc::asio;
+using namespace bc::chain;
+using namespace bc::machine;
+
+const size_t bloom_filter::maximum_filter_size = 36000;
+const size_t bloom_filter::maximum_hash_functions = 50;
+const size_t bloom_filter::maximum_element_size = 520;
+
+// Seeds of the hash functions are spaced by this constant (bip37).
+static const uint32_t seed_spacing = 0xfba4c795;
+
+static const duration window = seconds(1);
+
+typedef std::array<uint32_t, bloom_filter::maximum_hash_functions> lanes;
+
+static uint32_t rotate(uint32_t value, uint32_t bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static uint32_t scramble(uint32_t value)
+{
+    return rotate(value * 0xcc9e2d51, 15) * 0x1b873593;
+}
+
+// Murmur3 (x86_32) of the element for each of the seeds, in one pass. The
+// element words are scrambled once and mixed into each lane, and the lanes
+// are independent, so the inner loops are vectorized by the compiler.
+static void murmur3(lanes& hashes, size_t count, data_slice element)
+{
+    const auto size = element.size();
+    const auto blocks = size / sizeof(uint32_t);
+    auto data = element.begin();
+
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        const auto word = scramble(from_little_endian_unsafe<uint32_t>(data));
+        data += sizeof(uint32_t);
+
+        for (size_t lane = 0; lane < count; ++lane)
+            hashes[lane] = rotate(hashes[lane] ^ word, 13) * 5 + 0xe6546b64;
+    }
+
+    uint32_t tail = 0;
+    const auto remainder = size % sizeof(uint32_t);
+
+    if (remainder == 3)
+        tail ^= static_cast<uint32_t>(data[2]) << 16;
+
+    if (remainder >= 2)
+        tail ^= static_cast<uint32_t>(data[1]) << 8;
+
+    if (remainder >= 1)
+        tail = scramble(tail ^ data[0]);
+
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        auto hash = hashes[lane] ^ tail ^ static_cast<uint32_t>(size);
+        hash = (hash ^ (hash >> 16)) * 0x85ebca6b;
+        hash = (hash ^ (hash >> 13)) * 0xc2b2ae35;
+        hashes[lane] = hash ^ (hash >> 16);
+    }
+}
+
+static bool is_empty(const data_chunk& bits)
+{
+    return std::all_of(bits.begin(), bits.end(),
+        [](uint8_t byte) { return byte == 0x00; });
+}
+
+static bool is_full(const data_chunk& bits)
+{
+    return std::all_of(bits.begin(), bits.end(),
+        [](uint8_t byte) { return byte == 0xff; });
+}
+
+bool bloom_filter::valid(const message::filter_load& message)
+{
+    return message.filter().size() <= maximum_filter_size &&
+        message.hash_functions() <= maximum_hash_functions;
+}
+
+bloom_filter::bloom_filter(const message::filter_load& message,
+    const duration& budget)
+  : tweak_(message.tweak()),
+    update_(static_cast<update>(message.flags() & 0x03)),
+    budget_(budget),
+    bits_(message.filter()),
+    functions_(std::min<size_t>(message.hash_functions(),
+        maximum_hash_functions)),
+    empty_(is_empty(bits_)),
+    full_(is_full(bits_)),
+    window_(steady_clock::now()),
+    spent_(duration::zero())
+{
+}
+
+// Elements.
+// ----------------------------------------------------------------------------
+
+void bloom_filter::insert(data_slice element)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    do_insert(element);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool bloom_filter::contains(data_slice element) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return do_contains(element);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void bloom_filter::do_insert(data_slice element)
+{
+    if (bits_.empty() || full_)
+        return;
+
+    lanes hashes;
+    for (size_t lane = 0; lane < functions_; ++lane)
+        hashes[lane] = lane * seed_spacing + tweak_;
+
+    murmur3(hashes, functions_, element);
+    const auto size = bits_.size() * byte_bits;
+
+    for (size_t lane = 0; lane < functions_; ++lane)
+    {
+        const auto bit = hashes[lane] % size;
+        bits_[bit >> 3] |= (1 << (bit & 7));
+    }
+
+    empty_ = false;
+}
+
+bool bloom_filter::do_contains(data_slice element) const
+{
+    if (full_)
+        return true;
+
+    if (empty_)
+        return false;
+
+    lanes hashes;
+    for (size_t lane = 0; lane < functions_; ++lane)
+        hashes[lane] = lane * seed_spacing + tweak_;
+
+    murmur3(hashes, functions_, element);
+    const auto size = bits_.size() * byte_bits;
+
+    for (size_t lane = 0; lane < functions_; ++lane)
+    {
+        const auto bit = hashes[lane] % size;
+
+        if ((bits_[bit >> 3] & (1 << (bit & 7))) == 0)
+            return false;
+    }
+
+    return true;
+}
+
+// Transactions.
+// ----------------------------------------------------------------------------
+
+bool bloom_filter::matches(const transaction& tx)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    refresh();
+
+    if (spent_ >= budget_)
+        return false;
+
+    const auto start = steady_clock::now();
+    const auto result = match(tx);
+    spent_ += steady_clock::now() - start;
+    return result;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool bloom_filter::matches(const block& block, std::vector<bool>& out)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    refresh();
+
+    if (spent_ >= budget_)
+        return false;
+
+    const auto start = steady_clock::now();
+    const auto& transactions = block.transactions();
+    out.clear();
+    out.reserve(transactions.size());
+
+    for (const auto& tx: transactions)
+        out.push_back(match(tx));
+
+    spent_ += steady_clock::now() - start;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Restore the budget at the start of each window.
+void bloom_filter::refresh()
+{
+    const auto now = steady_clock::now();
+
+    if (now - window_ < window)
+        return;
+
+    window_ = now;
+    spent_ = duration::zero();
+}
+
+bool bloom_filter::match(const transaction& tx)
+{
+    if (full_)
+        return true;
+
+    if (empty_)
+        return false;
+
+    const auto hash = tx.hash();
+    auto matched = do_contains(hash);
+    const auto& outputs = tx.outputs();
+
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+    {
+        const auto& script = outputs[index].script();
+
+        for (const auto& operation: script.operations())
+        {
+            const auto& data = operation.data();
+
+            if (data.empty() || !do_contains(data))
+                continue;
+
+            matched = true;
+            const auto pattern = script.output_pattern();
+
+            if (update_ == update::all || (update_ == update::pay_key_only &&
+                (pattern == script_pattern::pay_public_key ||
+                pattern == script_pattern::pay_multisig)))
+                do_insert(output_point{ hash, index }.to_data());
+
+            break;
+        }
+    }
+
+    if (matched)
+        return true;
+
+    for (const auto& input: tx.inputs())
+    {
+        if (do_contains(input.previous_output().to_data()))
+            return true;
+
+        for (const auto& operation: input.script().operations())
+        {
+            const auto& data = operation.data();
+
+            if (!data.empty() && do_contains(data))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -46,8 +46,20 @@ channel::channel(threadpool& pool, socket::ptr socket,
   : proxy(pool, socket, settings),
     notify_(false),
     nonce_(0),
+    best_known_header_(null_hash),
+    fee_filter_(0),
+    address_relay_(false),
+    anchor_(false),
+    latency_(asio::duration::zero()),
+    created_(asio::steady_clock::now()),
     expiration_(alarm(pool, settings.channel_expiration())),
     inactivity_(alarm(pool, settings.channel_inactivity())),
+    announce_subscriber_(std::make_shared<announce_subscriber>(pool,
+        "channel_announce_sub")),
+    headers_subscriber_(std::make_shared<headers_subscriber>(pool,
+        "channel_headers_sub")),
+    transaction_subscriber_(std::make_shared<transaction_subscriber>(pool,
+        "channel_transaction_sub")),
     CONSTRUCT_TRACK(channel)
 {
 }
@@ -58,6 +70,10 @@ channel::channel(threadpool& pool, socket::ptr socket,
 // public:
 void channel::start(result_handler handler)
 {
+    announce_subscriber_->start();
+    headers_subscriber_->start();
+    transaction_subscriber_->start();
+
     proxy::start(
         std::bind(&channel::do_start,
             shared_from_base<channel>(), _1, handler));
@@ -71,6 +87,40 @@ void channel::do_start(const code& ec, result_handler handler)
     handler(error::success);
 }
 
+// Announcements.
+// ----------------------------------------------------------------------------
+
+void channel::subscribe_announcement(announce_handler handler)
+{
+    announce_subscriber_->subscribe(handler, error::channel_stopped, {}, 0);
+}
+
+void channel::subscribe_header_announcement(headers_handler handler)
+{
+    headers_subscriber_->subscribe(handler, error::channel_stopped, {});
+}
+
+void channel::subscribe_transaction_announcement(transaction_handler handler)
+{
+    transaction_subscriber_->subscribe(handler, error::channel_stopped, {},
+        0);
+}
+
+void channel::announce(inventory_const_ptr inventory, uint64_t fee_rate)
+{
+    announce_subscriber_->relay(error::success, inventory, fee_rate);
+}
+
+void channel::announce(headers_const_ptr headers)
+{
+    headers_subscriber_->relay(error::success, headers);
+}
+
+void channel::announce(transaction_const_ptr transaction, uint64_t fee_rate)
+{
+    transaction_subscriber_->relay(error::success, transaction, fee_rate);
+}
+
 // Properties.
 // ----------------------------------------------------------------------------
 
@@ -106,6 +156,94 @@ void channel::set_peer_version(version_const_ptr value)
     peer_version_.store(value);
 }
 
+// The most recent block announced by or to the peer, null if none.
+hash_digest channel::best_known_header() const
+{
+    return best_known_header_.load();
+}
+
+void channel::set_best_known_header(const hash_digest& value)
+{
+    best_known_header_.store(value);
+}
+
+// The minimum fee rate of transactions announced to the peer (bip133).
+uint64_t channel::fee_filter() const
+{
+    return fee_filter_;
+}
+
+void channel::set_fee_filter(uint64_t value)
+{
+    fee_filter_ = value;
+}
+
+// The transaction filter of the peer (bip37), null if none.
+bloom_filter::ptr channel::filter() const
+{
+    return filter_.load();
+}
+
+void channel::set_filter(bloom_filter::ptr value)
+{
+    filter_.store(value);
+}
+
+// The transactions to be reconciled with the peer (erlay), null if none.
+reconciliation_set::ptr channel::reconciliation() const
+{
+    return reconciliation_.load();
+}
+
+void channel::set_reconciliation(reconciliation_set::ptr value)
+{
+    reconciliation_.store(value);
+}
+
+// The peer participates in address gossip (not block-relay-only).
+bool channel::address_relay() const
+{
+    return address_relay_;
+}
+
+void channel::set_address_relay(bool value)
+{
+    address_relay_ = value;
+}
+
+// The channel is an outbound peer, a candidate to be dialed upon restart.
+bool channel::anchor() const
+{
+    return anchor_;
+}
+
+void channel::set_anchor(bool value)
+{
+    anchor_ = value;
+}
+
+// The most recent ping round trip time, zero if not measured.
+asio::duration channel::latency() const
+{
+    return latency_.load();
+}
+
+void channel::set_latency(const asio::duration& value)
+{
+    latency_.store(value);
+}
+
+// The time elapsed since the channel was created.
+asio::duration channel::uptime() const
+{
+    return asio::steady_clock::now() - created_;
+}
+
+void channel::set_expiration_handler(result_handler handler)
+{
+    expiration_handler_.store(handler);
+}
+
 // Proxy pure virtual protected and ordered handlers.
 // ----------------------------------------------------------------------------
 
@@ -114,6 +252,26 @@ void channel::handle_stopping()
 {
     expiration_->stop();
     inactivity_->stop();
+
+    // Break the reference cycle through the bound channel, if any.
+    expiration_handler_.store({});
+
+    // Release announcement handlers, which hold protocols of this channel.
+    announce_subscriber_->stop();
+    announce_subscriber_->relay(error::channel_stopped, {}, 0);
+    headers_subscriber_->stop();
+    headers_subscriber_->relay(error::channel_stopped, {});
+    transaction_subscriber_->stop();
+    transaction_subscriber_->relay(error::channel_stopped, {}, 0);
+}
+
+// The peer knows the last header sent to it, and so all of its ancestors.
+void channel::sending(const message::headers& message)
+{
+    const auto& elements = message.elements();
+
+    if (!elements.empty())
+        set_best_known_header(elements.back().hash());
 }
 
 void channel::signal_activity()
@@ -148,6 +306,12 @@ void channel::handle_expiration(const code& ec)
     LOG_DEBUG(LOG_NETWORK)
         << "Channel lifetime expired [" << authority() << "]";
 
+    // Make before break.
+    const auto handler = expiration_handler_.load();
+
+    if (handler)
+        handler(error::channel_timeout);
+
     stop(error::channel_timeout);
 }
 
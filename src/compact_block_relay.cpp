@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/compact_block_relay.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/rolling_bloom_filter.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// The peer may send compact blocks before validation, so limit exposure.
+static const size_t maximum_high_bandwidth = 3;
+
+// A claimed block not completed in this time may be claimed by another peer.
+static const asio::seconds claim_timeout(30);
+
+// Completed blocks are retained for at least the most recent 1000.
+static const size_t completed_blocks = 1000;
+static const double completed_false_positive_rate = 0.000001;
+
+compact_block_relay::compact_block_relay()
+  : timeout_(claim_timeout),
+    completed_(completed_blocks, completed_false_positive_rate)
+{
+}
+
+// High bandwidth.
+// ----------------------------------------------------------------------------
+
+bool compact_block_relay::select(uint64_t peer)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (selected_.count(peer) != 0)
+        return true;
+
+    if (selected_.size() >= maximum_high_bandwidth)
+        return false;
+
+    selected_.insert(peer);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void compact_block_relay::disconnect(uint64_t peer)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    selected_.erase(peer);
+
+    for (auto it = claims_.begin(); it != claims_.end();)
+        it = it->second.peer == peer ? claims_.erase(it) : std::next(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t compact_block_relay::high_bandwidth() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return selected_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Claims.
+// ----------------------------------------------------------------------------
+
+bool compact_block_relay::claim(uint64_t peer, const hash_digest& hash)
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (completed_.contains(hash))
+        return false;
+
+    const auto it = claims_.find(hash);
+
+    if (it != claims_.end() && it->second.peer != peer &&
+        now - it->second.time <= timeout_)
+        return false;
+
+    claims_[hash] = { peer, now };
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void compact_block_relay::completed(const hash_digest& hash)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    claims_.erase(hash);
+    completed_.insert(hash);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace network
+} // namespace libbitcoin
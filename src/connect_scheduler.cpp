@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/connect_scheduler.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// The adaptive timeout is never less than this.
+static const asio::milliseconds minimum_timeout(500);
+
+// The delay before a failed host is dialed again is never more than this.
+static const asio::minutes maximum_delay(10);
+
+// The delay doubles with each failure, up to this many doublings.
+static const size_t maximum_doublings = 16;
+
+// Bound the number of failed hosts retained (to bound memory).
+static const size_t maximum_hosts = 10000;
+
+connect_scheduler::connect_scheduler(const settings& settings)
+  : maximum_timeout_(std::max<asio::duration>(settings.connect_timeout(),
+        minimum_timeout)),
+    minimum_delay_(settings.connect_timeout()),
+    sampled_(false),
+    smoothed_(asio::duration::zero()),
+    variation_(asio::duration::zero()),
+    timeout_(maximum_timeout_)
+{
+}
+
+// Timeout.
+// ----------------------------------------------------------------------------
+// The timeout is computed as a TCP retransmission timeout (rfc6298).
+
+asio::duration connect_scheduler::timeout() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return timeout_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void connect_scheduler::sampled(const asio::duration& round_trip)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (!sampled_)
+    {
+        sampled_ = true;
+        smoothed_ = round_trip;
+        variation_ = round_trip / 2;
+    }
+    else
+    {
+        const auto deviation = smoothed_ > round_trip ?
+            smoothed_ - round_trip : round_trip - smoothed_;
+        variation_ += (deviation - variation_) / 4;
+        smoothed_ += (round_trip - smoothed_) / 8;
+    }
+
+    timeout_ = std::min(maximum_timeout_, std::max<asio::duration>(
+        smoothed_ + 4 * variation_, minimum_timeout));
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The timeout backs off until another round trip is sampled.
+void connect_scheduler::timed_out()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    timeout_ = std::min(maximum_timeout_, 2 * timeout_);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Backoff.
+// ----------------------------------------------------------------------------
+
+void connect_scheduler::failed(const config::endpoint& host)
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (hosts_.size() >= maximum_hosts)
+        prune(now);
+
+    auto& item = hosts_[{ host.host(), host.port() }];
+    const auto doublings = std::min(item.failures, maximum_doublings);
+    item.failures++;
+
+    // Jitter spreads the retries of hosts that failed together (partition).
+    const auto delay = std::min<asio::duration>(minimum_delay_ *
+        (uint64_t(1) << doublings), maximum_delay);
+    item.retry = now + pseudo_randomize(delay);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void connect_scheduler::succeeded(const config::endpoint& host)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    hosts_.erase({ host.host(), host.port() });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+asio::duration connect_scheduler::delay(const config::endpoint& host) const
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = hosts_.find({ host.host(), host.port() });
+
+    if (it == hosts_.end() || it->second.retry <= now)
+        return asio::duration::zero();
+
+    return it->second.retry - now;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Drop the hosts that may be dialed again, or if none, an arbitrary host.
+void connect_scheduler::prune(const asio::time_point& now)
+{
+    for (auto it = hosts_.begin(); it != hosts_.end();)
+        it = it->second.retry <= now ? hosts_.erase(it) : std::next(it);
+
+    if (hosts_.size() >= maximum_hosts)
+        hosts_.erase(hosts_.begin());
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -36,10 +36,12 @@ namespace network {
 using namespace bc::config;
 using namespace std::placeholders;
 
-connector::connector(threadpool& pool, const settings& settings)
+connector::connector(threadpool& pool, const settings& settings,
+    connect_scheduler::ptr scheduler)
   : stopped_(false),
     pool_(pool),
     settings_(settings),
+    scheduler_(scheduler),
     dispatch_(pool, NAME),
     resolver_(pool.service()),
     CONSTRUCT_TRACK(connector)
@@ -149,7 +151,8 @@ void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
     }
 
     const auto socket = std::make_shared<bc::socket>(pool_);
-    timer_ = std::make_shared<deadline>(pool_, settings_.connect_timeout());
+    const auto started = asio::steady_clock::now();
+    timer_ = std::make_shared<deadline>(pool_, scheduler_->timeout());
 
     // Manage the timer-connect race, returning upon first completion.
     const auto join_handler = synchronize(handler, 1, NAME,
@@ -164,31 +167,110 @@ void connector::handle_resolve(const boost_code& ec, asio::iterator iterator,
     // The bound delegate ensures handler completion before loss of scope.
     async_connect(socket->get(), iterator,
         std::bind(&connector::handle_connect,
-            shared_from_this(), _1, _2, socket, join_handler));
+            shared_from_this(), _1, _2, socket, started, join_handler));
 
     mutex_.unlock_shared();
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Resolve.
+// ----------------------------------------------------------------------------
+// DNS seeds return the addresses of nodes, not of themselves, as records.
+
+void connector::resolve(const endpoint& endpoint, resolve_handler handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    if (stopped())
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        dispatch_.concurrent(handler, error::service_stopped, address_list{});
+        return;
+    }
+
+    query_ = std::make_shared<asio::query>(endpoint.host(),
+        std::to_string(endpoint.port()));
+
+    mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+    // async_resolve will not invoke the handler within this function.
+    resolver_.async_resolve(*query_,
+        std::bind(&connector::handle_records,
+            shared_from_this(), _1, _2, handler));
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private:
+void connector::handle_records(const boost_code& ec, asio::iterator iterator,
+    resolve_handler handler)
+{
+    if (stopped())
+    {
+        handler(error::service_stopped, {});
+        return;
+    }
+
+    if (ec)
+    {
+        handler(error::resolve_failed, {});
+        return;
+    }
+
+    // Seeds are presumed to list recently-seen full nodes.
+    const auto now = static_cast<uint32_t>(zulu_time());
+    const auto services = message::version::service::node_network;
+    address_list addresses;
+
+    for (; iterator != asio::iterator(); ++iterator)
+    {
+        auto address = authority(iterator->endpoint()).to_network_address();
+        address.set_timestamp(now);
+        address.set_services(services);
+        addresses.push_back(address);
+    }
+
+    handler(error::success, addresses);
+}
+
 // private:
 void connector::handle_connect(const boost_code& ec, asio::iterator,
-    socket::ptr socket, connect_handler handler)
+    socket::ptr socket, const asio::time_point& started,
+    connect_handler handler)
 {
     if (ec)
     {
         handler(error::boost_to_error_code(ec), nullptr);
+
+        // The handler is first invoked so that it wins the race (on_error).
+        timer_->stop();
         return;
     }
 
+    // The connection time approximates the round trip time of the peer.
+    scheduler_->sampled(asio::steady_clock::now() - started);
+
     // Ensure that channel is not passed as an r-value.
     const auto created = std::make_shared<channel>(pool_, socket, settings_);
     handler(error::success, created);
+
+    // The handler is first invoked so that it wins the race (on_error).
+    timer_->stop();
 }
 
 // private:
 void connector::handle_timer(const code& ec, socket::ptr socket,
     connect_handler handler)
 {
+    // The timer is stopped upon connection, so only expiration is a timeout.
+    if (!ec)
+        scheduler_->timed_out();
+
     handler(ec ? ec : error::channel_timeout, nullptr);
 }
 
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <numeric>
 #include <string>
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
@@ -37,6 +38,7 @@ hosts::hosts(const settings& settings)
   : buffer_(std::max(settings.host_pool_capacity, 1u)),
     stopped_(true),
     file_path_(settings.hosts_file),
+    anchors_path_(settings.anchors_file),
     disabled_(settings.host_pool_capacity == 0)
 {
 }
@@ -85,6 +87,39 @@ code hosts::fetch(address& out) const
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Randomly select up to count distinct addresses from the buffer.
+hosts::address::list hosts::sample(size_t count) const
+{
+    address::list out;
+
+    if (disabled_)
+        return out;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (stopped_)
+        return out;
+
+    const auto size = buffer_.size();
+    const auto take = std::min(count, size);
+    std::vector<size_t> indexes(size);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    out.reserve(take);
+
+    // Partial Fisher-Yates shuffle of the indexes.
+    for (size_t index = 0; index < take; ++index)
+    {
+        const auto random = pseudo_random(index, size - 1);
+        std::swap(indexes[index], indexes[static_cast<size_t>(random)]);
+        out.push_back(buffer_[indexes[index]]);
+    }
+
+    return out;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 // load
 code hosts::start()
 {
@@ -123,6 +158,7 @@ code hosts::start()
         }
     }
 
+    read_anchors();
     mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
@@ -171,6 +207,7 @@ code hosts::stop()
         buffer_.clear();
     }
 
+    write_anchors();
     mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
@@ -184,6 +221,108 @@ code hosts::stop()
     return error::success;
 }
 
+// Anchors.
+// ----------------------------------------------------------------------------
+
+// private
+// Anchors are dialed once, so the file is removed upon load. This prevents a
+// node that fails to shut down cleanly from dialing stale anchors.
+void hosts::read_anchors()
+{
+    bc::ifstream file(anchors_path_.string());
+
+    if (!file.bad())
+    {
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            config::authority host(line);
+
+            if (host.port() != 0)
+                anchors_.push_back(host.to_network_address());
+        }
+    }
+
+    file.close();
+    boost::system::error_code ignored;
+    boost::filesystem::remove(anchors_path_, ignored);
+}
+
+// private
+void hosts::write_anchors()
+{
+    if (anchors_.empty())
+        return;
+
+    bc::ofstream file(anchors_path_.string());
+
+    if (file.bad())
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failed to save anchors file.";
+        return;
+    }
+
+    for (const auto& entry: anchors_)
+        file << config::authority(entry) << std::endl;
+
+    anchors_.clear();
+}
+
+code hosts::fetch_anchor(address& out)
+{
+    if (disabled_)
+        return error::not_found;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    if (stopped_)
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return error::service_stopped;
+    }
+
+    if (anchors_.empty())
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return error::not_found;
+    }
+
+    mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+    // Anchors are ranked, so are fetched in order.
+    out = anchors_.front();
+    anchors_.erase(anchors_.begin());
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return error::success;
+}
+
+// Set the anchors to be saved upon stop, replacing any not yet fetched.
+void hosts::save_anchors(const address::list& anchors)
+{
+    if (disabled_)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (!stopped_)
+        anchors_ = anchors;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 code hosts::remove(const address& host)
 {
     if (disabled_)
@@ -30,14 +30,10 @@
 #define RELAY_CODE(code, value) \
     value##_subscriber_->relay(code, {})
 
-// This allows us to block the peer while handling the message.
-#define CASE_HANDLE_MESSAGE(stream, version, value) \
+#define CASE_LOAD_MESSAGE(stream, version, value) \
     case message_type::value: \
-        return handle<message::value>(stream, version, value##_subscriber_)
-
-#define CASE_RELAY_MESSAGE(stream, version, value) \
-    case message_type::value: \
-        return relay<message::value>(stream, version, value##_subscriber_)
+        return load<message::value>(delivery_policy(type), stream, \
+            version, value##_subscriber_, complete, payload)
 
 #define START_SUBSCRIBER(value) \
     value##_subscriber_->start()
@@ -51,7 +47,8 @@ namespace network {
 using namespace message;
 
 message_subscriber::message_subscriber(threadpool& pool)
-  : INITIALIZE_SUBSCRIBER(pool, address),
+  : dispatch_(pool, "message_sub"),
+    INITIALIZE_SUBSCRIBER(pool, address),
     INITIALIZE_SUBSCRIBER(pool, alert),
     INITIALIZE_SUBSCRIBER(pool, block),
     INITIALIZE_SUBSCRIBER(pool, block_transactions),
@@ -79,6 +76,45 @@ message_subscriber::message_subscriber(threadpool& pool)
     INITIALIZE_SUBSCRIBER(pool, verack),
     INITIALIZE_SUBSCRIBER(pool, version)
 {
+    // Messages not listed here are relayed by default.
+    // This allows us to block the peer while handling the message.
+    delivery_[message_type::block] = delivery::handle;
+    delivery_[message_type::ping] = delivery::handle;
+    delivery_[message_type::pong] = delivery::handle;
+    delivery_[message_type::transaction] = delivery::handle;
+    delivery_[message_type::verack] = delivery::handle;
+    delivery_[message_type::version] = delivery::handle;
+}
+
+// Delivery policy.
+// ----------------------------------------------------------------------------
+
+delivery message_subscriber::delivery_policy(message_type type) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    const auto it = delivery_.find(type);
+    return it == delivery_.end() ? delivery::relay : it->second;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void message_subscriber::set_delivery_policy(message_type type,
+    delivery policy)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    delivery_[type] = policy;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void message_subscriber::set_dedicated_pool(threadpool& pool)
+{
+    dedicated_.store(std::make_shared<dispatcher>(pool,
+        "message_dedicated"));
 }
 
 void message_subscriber::broadcast(const code& ec)
@@ -114,42 +150,64 @@ void message_subscriber::broadcast(const code& ec)
 
 code message_subscriber::load(message_type type, uint32_t version,
     std::istream& stream) const
+{
+    const auto nop = []() {};
+    return load(type, version, stream, nop);
+}
+
+code message_subscriber::load(message_type type, uint32_t version,
+    std::istream& stream, completion_handler complete) const
+{
+    return load(type, version, stream, {}, complete);
+}
+
+code message_subscriber::load(message_type type, uint32_t version,
+    std::istream& stream, const wire_payload& payload,
+    completion_handler complete) const
 {
     switch (type)
     {
-        CASE_RELAY_MESSAGE(stream, version, address);
-        CASE_RELAY_MESSAGE(stream, version, alert);
-        CASE_HANDLE_MESSAGE(stream, version, block);
-        CASE_RELAY_MESSAGE(stream, version, block_transactions);
-        CASE_RELAY_MESSAGE(stream, version, compact_block);
-        CASE_RELAY_MESSAGE(stream, version, fee_filter);
-        CASE_RELAY_MESSAGE(stream, version, filter_add);
-        CASE_RELAY_MESSAGE(stream, version, filter_clear);
-        CASE_RELAY_MESSAGE(stream, version, filter_load);
-        CASE_RELAY_MESSAGE(stream, version, get_address);
-        CASE_RELAY_MESSAGE(stream, version, get_blocks);
-        CASE_RELAY_MESSAGE(stream, version, get_block_transactions);
-        CASE_RELAY_MESSAGE(stream, version, get_data);
-        CASE_RELAY_MESSAGE(stream, version, get_headers);
-        CASE_RELAY_MESSAGE(stream, version, headers);
-        CASE_RELAY_MESSAGE(stream, version, inventory);
-        CASE_RELAY_MESSAGE(stream, version, memory_pool);
-        CASE_RELAY_MESSAGE(stream, version, merkle_block);
-        CASE_RELAY_MESSAGE(stream, version, not_found);
-        CASE_HANDLE_MESSAGE(stream, version, ping);
-        CASE_HANDLE_MESSAGE(stream, version, pong);
-        CASE_RELAY_MESSAGE(stream, version, reject);
-        CASE_RELAY_MESSAGE(stream, version, send_compact);
-        CASE_RELAY_MESSAGE(stream, version, send_headers);
-        CASE_HANDLE_MESSAGE(stream, version, transaction);
-        CASE_HANDLE_MESSAGE(stream, version, verack);
-        CASE_HANDLE_MESSAGE(stream, version, version);
+        CASE_LOAD_MESSAGE(stream, version, address);
+        CASE_LOAD_MESSAGE(stream, version, alert);
+        CASE_LOAD_MESSAGE(stream, version, block);
+        CASE_LOAD_MESSAGE(stream, version, block_transactions);
+        CASE_LOAD_MESSAGE(stream, version, compact_block);
+        CASE_LOAD_MESSAGE(stream, version, fee_filter);
+        CASE_LOAD_MESSAGE(stream, version, filter_add);
+        CASE_LOAD_MESSAGE(stream, version, filter_clear);
+        CASE_LOAD_MESSAGE(stream, version, filter_load);
+        CASE_LOAD_MESSAGE(stream, version, get_address);
+        CASE_LOAD_MESSAGE(stream, version, get_blocks);
+        CASE_LOAD_MESSAGE(stream, version, get_block_transactions);
+        CASE_LOAD_MESSAGE(stream, version, get_data);
+        CASE_LOAD_MESSAGE(stream, version, get_headers);
+        CASE_LOAD_MESSAGE(stream, version, headers);
+        CASE_LOAD_MESSAGE(stream, version, inventory);
+        CASE_LOAD_MESSAGE(stream, version, memory_pool);
+        CASE_LOAD_MESSAGE(stream, version, merkle_block);
+        CASE_LOAD_MESSAGE(stream, version, not_found);
+        CASE_LOAD_MESSAGE(stream, version, ping);
+        CASE_LOAD_MESSAGE(stream, version, pong);
+        CASE_LOAD_MESSAGE(stream, version, reject);
+        CASE_LOAD_MESSAGE(stream, version, send_compact);
+        CASE_LOAD_MESSAGE(stream, version, send_headers);
+        CASE_LOAD_MESSAGE(stream, version, transaction);
+        CASE_LOAD_MESSAGE(stream, version, verack);
+        CASE_LOAD_MESSAGE(stream, version, version);
         case message_type::unknown:
         default:
             return error::not_found;
     }
 }
 
+code message_subscriber::load(block_const_ptr block,
+    completion_handler complete) const
+{
+    notify(delivery_policy(message_type::block), block, block_subscriber_,
+        complete);
+    return error::success;
+}
+
 void message_subscriber::start()
 {
     START_SUBSCRIBER(address);
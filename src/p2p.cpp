@@ -19,6 +19,7 @@
 #include <bitcoin/network/p2p.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -36,6 +37,7 @@
 #include <bitcoin/network/protocols/protocol_seed_31402.hpp>
 #include <bitcoin/network/protocols/protocol_version_31402.hpp>
 #include <bitcoin/network/protocols/protocol_version_70002.hpp>
+#include <bitcoin/network/sessions/session_block_relay.hpp>
 #include <bitcoin/network/sessions/session_inbound.hpp>
 #include <bitcoin/network/sessions/session_manual.hpp>
 #include <bitcoin/network/sessions/session_outbound.hpp>
@@ -50,17 +52,22 @@ namespace network {
 using namespace bc::config;
 using namespace std::placeholders;
 
+// Fresh addresses are relayed to this many peers (other than the source).
+static const size_t address_relay_fanout = 2;
+
 // This can be exceeded due to manual connection calls and race conditions.
 inline size_t nominal_connecting(const settings& settings)
 {
     return settings.peers.size() + settings.connect_batch_size *
-        settings.outbound_connections;
+        (settings.outbound_connections + settings.block_relay_connections +
+        settings.standby_connections);
 }
 
 // This can be exceeded due to manual connection calls and race conditions.
 inline size_t nominal_connected(const settings& settings)
 {
     return settings.peers.size() + settings.outbound_connections +
+        settings.block_relay_connections + settings.standby_connections +
         settings.inbound_connections;
 }
 
@@ -68,7 +75,16 @@ p2p::p2p(const settings& settings)
   : settings_(settings),
     stopped_(true),
     top_block_({ null_hash, 0 }),
+    shaper_(std::make_shared<upload_shaper>(threadpool_, settings_)),
+    transaction_scheduler_(std::make_shared<transaction_scheduler>(
+        threadpool_, settings_)),
+    block_scheduler_(std::make_shared<block_scheduler>(threadpool_,
+        settings_)),
+    compact_block_relay_(std::make_shared<compact_block_relay>()),
+    connect_scheduler_(std::make_shared<connect_scheduler>(settings_)),
+    fee_floor_(0),
     hosts_(settings_),
+    gossip_(std::make_shared<address_gossip>(threadpool_, hosts_)),
     pending_connect_(nominal_connecting(settings_)),
     pending_handshake_(nominal_connected(settings_)),
     pending_close_(nominal_connected(settings_)),
@@ -100,9 +116,28 @@ void p2p::start(result_handler handler)
     threadpool_.spawn(thread_default(settings_.threads),
         thread_priority::normal);
 
+    // Dedicated delivery keeps latency sensitive handlers off the main pool.
+    dedicated_pool_.join();
+    if (settings_.dedicated_threads != 0)
+        dedicated_pool_.spawn(settings_.dedicated_threads,
+            thread_priority::high);
+
     stopped_ = false;
     stop_subscriber_->start();
     channel_subscriber_->start();
+    shaper_->start();
+    gossip_->start();
+
+    if (settings_.schedule_transactions)
+        transaction_scheduler_->start();
+
+    if (settings_.schedule_blocks)
+        block_scheduler_->start();
+
+    // The hosts file is loaded in parallel with the manual session start.
+    const auto join_handler = synchronize(
+        std::bind(&p2p::handle_hosts_loaded,
+            this, _1, handler), 2, NAME, synchronizer_terminate::on_error);
 
     // This instance is retained by stop handler and member reference.
     manual_.store(attach_manual_session());
@@ -110,26 +145,32 @@ void p2p::start(result_handler handler)
     // This is invoked on a new thread.
     manual_.load()->start(
         std::bind(&p2p::handle_manual_started,
-            this, _1, handler));
+            this, _1, join_handler));
+
+    // This is invoked on a new thread.
+    threadpool_.service().post(
+        std::bind(&p2p::load_hosts,
+            this, join_handler));
 }
 
 void p2p::handle_manual_started(const code& ec, result_handler handler)
 {
-    if (stopped())
-    {
-        handler(error::service_stopped);
-        return;
-    }
-
     if (ec)
-    {
         LOG_ERROR(LOG_NETWORK)
             << "Error starting manual session: " << ec.message();
-        handler(ec);
-        return;
-    }
 
-    handle_hosts_loaded(hosts_.start(), handler);
+    handler(ec);
+}
+
+void p2p::load_hosts(result_handler handler)
+{
+    const auto ec = hosts_.start();
+
+    if (ec)
+        LOG_ERROR(LOG_NETWORK)
+            << "Error loading host addresses: " << ec.message();
+
+    handler(ec);
 }
 
 void p2p::handle_hosts_loaded(const code& ec, result_handler handler)
@@ -142,8 +183,6 @@ void p2p::handle_hosts_loaded(const code& ec, result_handler handler)
 
     if (ec)
     {
-        LOG_ERROR(LOG_NETWORK)
-            << "Error loading host addresses: " << ec.message();
         handler(ec);
         return;
     }
@@ -178,7 +217,7 @@ void p2p::handle_started(const code& ec, result_handler handler)
     // Subscription after this return will capture connections established via
     // subsequent "run" and "connect" calls, and will clear on close/destruct.
 
-    // This is the end of the start sequence.
+    // This is the end of the start sequence (seeding may continue).
     handler(error::success);
 }
 
@@ -215,6 +254,25 @@ void p2p::handle_inbound_started(const code& ec, result_handler handler)
 
     // This is invoked on a new thread.
     outbound->start(
+        std::bind(&p2p::handle_outbound_started,
+            this, _1, handler));
+}
+
+void p2p::handle_outbound_started(const code& ec, result_handler handler)
+{
+    if (ec)
+    {
+        LOG_ERROR(LOG_NETWORK)
+            << "Error starting outbound session: " << ec.message();
+        handler(ec);
+        return;
+    }
+
+    // The instance is retained by the stop handler (until shutdown).
+    const auto block_relay = attach_block_relay_session();
+
+    // This is invoked on a new thread.
+    block_relay->start(
         std::bind(&p2p::handle_running,
             this, _1, handler));
 }
@@ -224,7 +282,7 @@ void p2p::handle_running(const code& ec, result_handler handler)
     if (ec)
     {
         LOG_ERROR(LOG_NETWORK)
-            << "Error starting outbound session: " << ec.message();
+            << "Error starting block relay session: " << ec.message();
         handler(ec);
         return;
     }
@@ -257,6 +315,11 @@ session_outbound::ptr p2p::attach_outbound_session()
     return attach<session_outbound>(true);
 }
 
+session_block_relay::ptr p2p::attach_block_relay_session()
+{
+    return attach<session_block_relay>(true);
+}
+
 // Shutdown.
 // ----------------------------------------------------------------------------
 // All shutdown actions must be queued by the end of the stop call.
@@ -268,6 +331,9 @@ session_outbound::ptr p2p::attach_outbound_session()
 // is thread safe and idempotent, allowing it to be unguarded.
 bool p2p::stop()
 {
+    // Retain the best outbound peers to be dialed first upon restart.
+    hosts_.save_anchors(anchors());
+
     // This is the only stop operation that can fail.
     const auto result = (hosts_.stop() == error::success);
 
@@ -288,11 +354,61 @@ bool p2p::stop()
     pending_handshake_.stop(error::service_stopped);
     pending_close_.stop(error::service_stopped);
 
+    // Fail writes awaiting upload capacity.
+    shaper_->stop();
+    gossip_->stop();
+    transaction_scheduler_->stop();
+    block_scheduler_->stop();
+
     // Signal threadpool to stop accepting work now that subscribers are clear.
     threadpool_.shutdown();
+    dedicated_pool_.shutdown();
     return result;
 }
 
+// Outbound peers are ranked by uptime (to the minute), then by latency, with
+// those of unmeasured latency last.
+p2p::address::list p2p::anchors() const
+{
+    typedef std::pair<asio::minutes::rep, asio::duration> rank;
+    const auto ranking = [](const channel::ptr& channel)
+    {
+        const auto latency = channel->latency();
+        const auto uptime = std::chrono::duration_cast<asio::minutes>(
+            channel->uptime()).count();
+
+        return rank(-uptime, latency == asio::duration::zero() ?
+            asio::duration::max() : latency);
+    };
+
+    std::vector<std::pair<rank, channel::ptr>> ranked;
+
+    for (const auto& channel: pending_close_.collection())
+        if (channel->anchor())
+            ranked.emplace_back(ranking(channel), channel);
+
+    std::sort(ranked.begin(), ranked.end(),
+        [](const std::pair<rank, channel::ptr>& left,
+            const std::pair<rank, channel::ptr>& right)
+        {
+            return left.first < right.first;
+        });
+
+    address::list out;
+    const auto now = static_cast<uint32_t>(zulu_time());
+    const auto count = std::min(ranked.size(),
+        static_cast<size_t>(settings_.anchor_connections));
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        auto address = ranked[index].second->authority().to_network_address();
+        address.set_timestamp(now);
+        out.push_back(address);
+    }
+
+    return out;
+}
+
 // This must be called from the thread that constructed this class (see join).
 bool p2p::close()
 {
@@ -301,6 +417,7 @@ bool p2p::close()
 
     // Block on join of all threads in the threadpool.
     threadpool_.join();
+    dedicated_pool_.join();
     return result;
 }
 
@@ -337,6 +454,66 @@ threadpool& p2p::thread_pool()
     return threadpool_;
 }
 
+threadpool& p2p::dedicated_pool()
+{
+    return dedicated_pool_;
+}
+
+upload_shaper::ptr p2p::shaper()
+{
+    return shaper_;
+}
+
+transaction_scheduler::ptr p2p::transaction_downloads()
+{
+    return transaction_scheduler_;
+}
+
+block_scheduler::ptr p2p::block_downloads()
+{
+    return block_scheduler_;
+}
+
+compact_block_relay::ptr p2p::compact_blocks()
+{
+    return compact_block_relay_;
+}
+
+connect_scheduler::ptr p2p::connect_attempts()
+{
+    return connect_scheduler_;
+}
+
+transaction_source::ptr p2p::transaction_pool() const
+{
+    return transaction_pool_.load();
+}
+
+void p2p::set_transaction_pool(transaction_source::ptr pool)
+{
+    transaction_pool_.store(pool);
+}
+
+uint64_t p2p::fee_floor() const
+{
+    return fee_floor_;
+}
+
+void p2p::set_fee_floor(uint64_t fee_rate)
+{
+    fee_floor_ = fee_rate;
+}
+
+block_source::ptr p2p::block_store() const
+{
+    return block_store_.load();
+}
+
+void p2p::set_block_store(block_source::ptr store)
+{
+    block_store_.store(store);
+}
+
 // Send.
 // ----------------------------------------------------------------------------
 
@@ -361,6 +538,52 @@ void p2p::subscribe_stop(result_handler handler)
     stop_subscriber_->subscribe(handler, error::service_stopped);
 }
 
+// Announcements.
+// ----------------------------------------------------------------------------
+
+void p2p::announce(const message::inventory_vector::list& items)
+{
+    announce(items, 0);
+}
+
+// A zero fee rate is not subject to peer fee filters.
+void p2p::announce(const message::inventory_vector::list& items,
+    uint64_t fee_rate)
+{
+    if (stopped() || items.empty())
+        return;
+
+    const auto inventory = std::make_shared<const message::inventory>(items);
+
+    for (const auto channel: pending_close_.collection())
+        channel->announce(inventory, fee_rate);
+}
+
+void p2p::announce(const chain::header::list& headers)
+{
+    if (stopped() || headers.empty())
+        return;
+
+    // Announced blocks are complete, so are not relayed to us again.
+    for (const auto& header: headers)
+        compact_block_relay_->completed(header.hash());
+
+    const auto announcement = std::make_shared<const message::headers>(
+        headers);
+
+    for (const auto channel: pending_close_.collection())
+        channel->announce(announcement);
+}
+
+void p2p::announce(transaction_const_ptr transaction, uint64_t fee_rate)
+{
+    if (stopped() || !transaction)
+        return;
+
+    for (const auto channel: pending_close_.collection())
+        channel->announce(transaction, fee_rate);
+}
+
 // Manual connections.
 // ----------------------------------------------------------------------------
 
@@ -415,11 +638,70 @@ void p2p::store(const address::list& addresses, result_handler handler)
     hosts_.store(addresses, handler);
 }
 
+void p2p::gossip(const address::list& addresses)
+{
+    // Storage is invoked on a new thread, in batches.
+    gossip_->store(addresses);
+}
+
+// Each relay picks its own random peers, so fresh addresses diffuse without
+// flooding. Relayed addresses are not relayed again while recently relayed.
+void p2p::relay(const address::list& addresses, channel::ptr source)
+{
+    const auto relayable = gossip_->relayable(addresses);
+
+    if (relayable.empty())
+        return;
+
+    auto channels = pending_close_.collection();
+    const auto excluded = [&source](const channel::ptr& channel)
+    {
+        return channel == source || !channel->address_relay();
+    };
+
+    channels.erase(std::remove_if(channels.begin(), channels.end(), excluded),
+        channels.end());
+
+    const auto targets = std::min(channels.size(), address_relay_fanout);
+    const message::address announcement(relayable);
+
+    // Partial Fisher-Yates selection of the targets.
+    for (size_t index = 0; index < targets; ++index)
+    {
+        const auto last = channels.size() - 1;
+        const auto pick = static_cast<size_t>(pseudo_random(index, last));
+        std::swap(channels[index], channels[pick]);
+        const auto channel = channels[index];
+
+        channel->send(announcement,
+            std::bind(&p2p::handle_relay,
+                this, _1, channel));
+    }
+}
+
+void p2p::handle_relay(const code& ec, channel::ptr channel)
+{
+    if (ec)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure relaying addresses to [" << channel->authority()
+            << "] " << ec.message();
+}
+
 code p2p::fetch_address(address& out_address) const
 {
     return hosts_.fetch(out_address);
 }
 
+code p2p::fetch_anchor(address& out_address)
+{
+    return hosts_.fetch_anchor(out_address);
+}
+
+address_const_ptr p2p::fetch_addresses() const
+{
+    return gossip_->sample();
+}
+
 code p2p::remove(const address& address)
 {
     return hosts_.remove(address);
@@ -0,0 +1,360 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/pin_sketch.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+// GF(2^32) is defined by the polynomial x^32 + x^7 + x^3 + x^2 + 1.
+static const uint64_t modulus = 0x10000008d;
+static const size_t field_bits = 32;
+
+// Root finding gives up after this many unproductive splits.
+static const size_t split_attempts = 64;
+
+typedef std::vector<uint32_t> polynomial;
+
+// Field arithmetic.
+// ----------------------------------------------------------------------------
+
+static uint32_t multiply(uint32_t left, uint32_t right)
+{
+    uint64_t product = 0;
+
+    for (size_t bit = 0; bit < field_bits; ++bit)
+        if (((right >> bit) & 1) != 0)
+            product ^= static_cast<uint64_t>(left) << bit;
+
+    for (auto bit = 2 * field_bits - 2; bit >= field_bits; --bit)
+        if (((product >> bit) & 1) != 0)
+            product ^= modulus << (bit - field_bits);
+
+    return static_cast<uint32_t>(product);
+}
+
+static uint32_t square(uint32_t value)
+{
+    return multiply(value, value);
+}
+
+// The inverse is value^(2^32 - 2), zero has no inverse.
+static uint32_t inverse(uint32_t value)
+{
+    uint32_t result = 1;
+
+    for (size_t bit = 1; bit < field_bits; ++bit)
+    {
+        value = square(value);
+        result = multiply(result, value);
+    }
+
+    return result;
+}
+
+// Polynomial arithmetic, coefficients are ordered from the constant term.
+// ----------------------------------------------------------------------------
+
+static void trim(polynomial& value)
+{
+    while (!value.empty() && value.back() == 0)
+        value.pop_back();
+}
+
+static void make_monic(polynomial& value)
+{
+    const auto factor = inverse(value.back());
+
+    for (auto& coefficient: value)
+        coefficient = multiply(coefficient, factor);
+}
+
+// Divide by the monic divisor, leaving the remainder in the dividend.
+static polynomial divide(polynomial& dividend, const polynomial& divisor)
+{
+    const auto degree = divisor.size() - 1;
+    trim(dividend);
+
+    if (dividend.size() < divisor.size())
+        return {};
+
+    polynomial quotient(dividend.size() - degree, 0);
+
+    for (auto index = dividend.size(); index-- > degree;)
+    {
+        const auto factor = dividend[index];
+
+        if (factor == 0)
+            continue;
+
+        quotient[index - degree] = factor;
+
+        for (size_t term = 0; term <= degree; ++term)
+            dividend[index - degree + term] ^= multiply(factor, divisor[term]);
+    }
+
+    trim(dividend);
+    return quotient;
+}
+
+// In characteristic two the square of a sum is the sum of the squares.
+static polynomial square_modulo(const polynomial& value,
+    const polynomial& divisor)
+{
+    polynomial result(value.empty() ? 0 : 2 * value.size() - 1, 0);
+
+    for (size_t index = 0; index < value.size(); ++index)
+        result[2 * index] = square(value[index]);
+
+    divide(result, divisor);
+    return result;
+}
+
+static polynomial gcd(polynomial left, polynomial right)
+{
+    trim(left);
+    trim(right);
+
+    while (!right.empty())
+    {
+        make_monic(right);
+        divide(left, right);
+        std::swap(left, right);
+    }
+
+    if (!left.empty())
+        make_monic(left);
+
+    return left;
+}
+
+// Find the roots of a monic polynomial that splits into distinct linear
+// factors, by splitting on the trace of random multiples of x (Berlekamp).
+static bool find_roots(const polynomial& value, pin_sketch::elements& out)
+{
+    const auto degree = value.size() - 1;
+
+    if (degree == 0)
+        return true;
+
+    if (degree == 1)
+    {
+        out.push_back(value[0]);
+        return true;
+    }
+
+    for (size_t attempt = 0; attempt < split_attempts; ++attempt)
+    {
+        const auto beta = static_cast<uint32_t>(pseudo_random(1, max_uint32));
+        polynomial term{ 0, beta };
+        auto trace = term;
+
+        for (size_t bit = 1; bit < field_bits; ++bit)
+        {
+            term = square_modulo(term, value);
+            trace.resize(std::max(trace.size(), term.size()), 0);
+
+            for (size_t index = 0; index < term.size(); ++index)
+                trace[index] ^= term[index];
+        }
+
+        auto factor = gcd(value, trace);
+        const auto factor_degree = factor.empty() ? 0 : factor.size() - 1;
+
+        if (factor_degree == 0 || factor_degree == degree)
+            continue;
+
+        auto remainder = value;
+        const auto other = divide(remainder, factor);
+        return find_roots(factor, out) && find_roots(other, out);
+    }
+
+    return false;
+}
+
+// The polynomial has distinct roots in the field only if it divides
+// x^(2^32) - x, as x^(2^32) = x for every element of the field.
+static bool splits(const polynomial& value)
+{
+    polynomial power{ 0, 1 };
+
+    for (size_t bit = 0; bit < field_bits; ++bit)
+        power = square_modulo(power, value);
+
+    power.resize(std::max<size_t>(power.size(), 2), 0);
+    power[1] ^= 1;
+    divide(power, value);
+    return power.empty();
+}
+
+// The error locator polynomial of the power sums (Berlekamp-Massey).
+static polynomial locator(const polynomial& sums)
+{
+    polynomial current{ 1 };
+    polynomial previous{ 1 };
+    size_t length = 0;
+    size_t shift = 1;
+    uint32_t last = 1;
+
+    for (size_t index = 0; index < sums.size(); ++index)
+    {
+        auto discrepancy = sums[index];
+
+        for (size_t term = 1; term <= length && term < current.size(); ++term)
+            discrepancy ^= multiply(current[term], sums[index - term]);
+
+        if (discrepancy == 0)
+        {
+            ++shift;
+            continue;
+        }
+
+        const auto factor = multiply(discrepancy, inverse(last));
+        auto next = current;
+        next.resize(std::max(next.size(), previous.size() + shift), 0);
+
+        for (size_t term = 0; term < previous.size(); ++term)
+            next[term + shift] ^= multiply(factor, previous[term]);
+
+        if (2 * length <= index)
+        {
+            length = index + 1 - length;
+            previous = std::move(current);
+            last = discrepancy;
+            shift = 1;
+        }
+        else
+        {
+            ++shift;
+        }
+
+        current = std::move(next);
+    }
+
+    current.resize(length + 1, 0);
+    return current;
+}
+
+// Sketch.
+// ----------------------------------------------------------------------------
+
+pin_sketch::pin_sketch(size_t capacity)
+  : syndromes_(capacity, 0)
+{
+}
+
+pin_sketch::pin_sketch(const data_chunk& data)
+  : syndromes_(data.size() / sizeof(uint32_t), 0)
+{
+    auto it = data.begin();
+
+    for (auto& syndrome: syndromes_)
+    {
+        syndrome = from_little_endian_unsafe<uint32_t>(it);
+        it += sizeof(uint32_t);
+    }
+}
+
+size_t pin_sketch::capacity() const
+{
+    return syndromes_.size();
+}
+
+// Syndromes are the sums of the odd powers of the elements.
+void pin_sketch::add(uint32_t element)
+{
+    if (element == 0)
+        return;
+
+    const auto squared = square(element);
+    auto power = element;
+
+    for (auto& syndrome: syndromes_)
+    {
+        syndrome ^= power;
+        power = multiply(power, squared);
+    }
+}
+
+bool pin_sketch::merge(const pin_sketch& other)
+{
+    if (other.capacity() != capacity())
+        return false;
+
+    for (size_t index = 0; index < syndromes_.size(); ++index)
+        syndromes_[index] ^= other.syndromes_[index];
+
+    return true;
+}
+
+bool pin_sketch::decode(elements& out) const
+{
+    out.clear();
+    const auto count = syndromes_.size();
+
+    // Even power sums are the squares of lower power sums.
+    polynomial sums(2 * count, 0);
+
+    for (size_t index = 0; index < count; ++index)
+        sums[2 * index] = syndromes_[index];
+
+    for (size_t index = 1; index < sums.size(); index += 2)
+        sums[index] = square(sums[index / 2]);
+
+    auto errors = locator(sums);
+    const auto degree = errors.size() - 1;
+
+    if (degree > count || errors.back() == 0)
+        return false;
+
+    if (degree == 0)
+        return true;
+
+    // The roots of the reversed locator are the elements.
+    std::reverse(errors.begin(), errors.end());
+    make_monic(errors);
+
+    if (!splits(errors) || !find_roots(errors, out))
+        return false;
+
+    return out.size() == degree;
+}
+
+data_chunk pin_sketch::to_data() const
+{
+    data_chunk data;
+    data.reserve(syndromes_.size() * sizeof(uint32_t));
+
+    for (const auto syndrome: syndromes_)
+    {
+        const auto bytes = to_little_endian(syndrome);
+        data.insert(data.end(), bytes.begin(), bytes.end());
+    }
+
+    return data;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -18,6 +18,9 @@
  */
 #include <bitcoin/network/protocols/protocol_address_31402.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/channel.hpp>
@@ -35,6 +38,15 @@ namespace network {
 using namespace bc::message;
 using namespace std::placeholders;
 
+// Addresses are accepted from a peer at this sustained rate.
+static const double tokens_per_second = 0.1;
+
+// Unused tokens accrue up to one full address message.
+static const double maximum_tokens = static_cast<double>(max_address);
+
+// Larger messages are responses to get_address, not fresh announcements.
+static const size_t maximum_relayed = 10;
+
 static message::address configured_self(const network::settings& settings)
 {
     if (settings.self.port() == 0)
@@ -47,7 +59,10 @@ protocol_address_31402::protocol_address_31402(p2p& network,
     channel::ptr channel)
   : protocol_events(network, channel, NAME),
     network_(network),
+    channel_(channel),
     self_(configured_self(network_.network_settings())),
+    tokens_(1),
+    refilled_(asio::steady_clock::now()),
     CONSTRUCT_TRACK(protocol_address_31402)
 {
 }
@@ -62,6 +77,9 @@ void protocol_address_31402::start()
     // Must have a handler to capture a shared self pointer in stop subscriber.
     protocol_events::start(BIND1(handle_stop, _1));
 
+    // The peer participates in address gossip, so may be a relay target.
+    channel_->set_address_relay(true);
+
     if (!self_.addresses().empty())
     {
         SEND2(self_, handle_send, _1, self_.command);
@@ -73,9 +91,52 @@ void protocol_address_31402::start()
 
     SUBSCRIBE2(address, handle_receive_address, _1, _2);
     SUBSCRIBE2(get_address, handle_receive_get_address, _1, _2);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    // The response to our request is not subject to the rate limit.
+    tokens_ += maximum_tokens;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
     SEND2(get_address{}, handle_send, _1, get_address::command);
 }
 
+// Rate limit.
+// ----------------------------------------------------------------------------
+
+// A bucket above the maximum (see start) is not refilled until drawn down.
+size_t protocol_address_31402::admit(double& tokens, size_t elapsed,
+    size_t count)
+{
+    if (tokens < maximum_tokens)
+        tokens = std::min(maximum_tokens,
+            tokens + tokens_per_second * elapsed / 1000.0);
+
+    const auto admitted = std::min(count, static_cast<size_t>(tokens));
+    tokens -= admitted;
+    return admitted;
+}
+
+size_t protocol_address_31402::admit(size_t count)
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto elapsed = std::chrono::duration_cast<asio::milliseconds>(
+        now - refilled_).count();
+
+    refilled_ = now;
+    return admit(tokens_, static_cast<size_t>(elapsed), count);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 // Protocol.
 // ----------------------------------------------------------------------------
 
@@ -85,12 +146,29 @@ bool protocol_address_31402::handle_receive_address(const code& ec,
     if (stopped(ec))
         return false;
 
+    const auto& addresses = message->addresses();
+    const auto count = admit(addresses.size());
+
+    if (count < addresses.size())
+        LOG_DEBUG(LOG_NETWORK)
+            << "Rate limited addresses from [" << authority() << "] ("
+            << addresses.size() - count << " of " << addresses.size() << ")";
+
+    if (count == 0)
+        return true;
+
+    const network_address::list admitted(addresses.begin(),
+        addresses.begin() + count);
+
     LOG_DEBUG(LOG_NETWORK)
         << "Storing addresses from [" << authority() << "] ("
-        << message->addresses().size() << ")";
+        << admitted.size() << ")";
 
     // TODO: manage timestamps (active channels are connected < 3 hours ago).
-    network_.store(message->addresses(), BIND1(handle_store_addresses, _1));
+    network_.gossip(admitted);
+
+    if (addresses.size() <= maximum_relayed)
+        network_.relay(admitted, channel_);
 
     // RESUBSCRIBE
     return true;
@@ -102,36 +180,22 @@ bool protocol_address_31402::handle_receive_get_address(const code& ec,
     if (stopped(ec))
         return false;
 
-    // TODO: allowing repeated queries can allow a channel to map our history.
-    // TODO: pull active hosts from host cache (currently just resending self).
     // TODO: need to distort for privacy, don't send currently-connected peers.
-    // TODO: response size limit is max_address (1000).
+    // The sample is cached, so repeated queries cannot map the host pool.
+    const auto sample = network_.fetch_addresses();
+    const auto& response = sample->addresses().empty() ? self_ : *sample;
 
-    if (self_.addresses().empty())
+    if (response.addresses().empty())
         return false;
 
     LOG_DEBUG(LOG_NETWORK)
         << "Sending addresses to [" << authority() << "] ("
-        << self_.addresses().size() << ")";
+        << response.addresses().size() << ")";
 
-    SEND2(self_, handle_send, _1, self_.command);
+    SEND2(response, handle_send, _1, response.command);
 
-    // RESUBSCRIBE
-    return true;
-}
-
-void protocol_address_31402::handle_store_addresses(const code& ec)
-{
-    if (stopped(ec))
-        return;
-
-    if (ec)
-    {
-        LOG_ERROR(LOG_NETWORK)
-            << "Failure storing addresses from [" << authority() << "] "
-            << ec.message();
-        stop(ec);
-    }
+    // Respond at most once per connection.
+    return false;
 }
 
 void protocol_address_31402::handle_stop(const code&)
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_block_download_31402.hpp>
+
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/wire_payload.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "block_download"
+#define CLASS protocol_block_download_31402
+
+using namespace bc::message;
+using namespace std::placeholders;
+
+// Request witness blocks if both we and the peer support witness.
+static inventory::type_id request_type(const network::settings& settings,
+    version_const_ptr peer)
+{
+    const auto witness = version::service::node_witness;
+    return (settings.services & witness) != 0 && peer &&
+        (peer->services() & witness) != 0 ?
+            inventory::type_id::witness_block :
+            inventory::type_id::block;
+}
+
+protocol_block_download_31402::protocol_block_download_31402(p2p& network,
+    channel::ptr channel)
+  : protocol_events(network, channel, NAME),
+    network_(network),
+    scheduler_(network.block_downloads()),
+    request_type_(request_type(network.network_settings(),
+        channel->peer_version())),
+    CONSTRUCT_TRACK(protocol_block_download_31402)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_block_download_31402::start()
+{
+    const auto peer = peer_version();
+
+    // Only full nodes serve blocks.
+    if (!peer || (peer->services() & version::service::node_network) == 0)
+        return;
+
+    protocol_events::start(BIND1(handle_stop, _1));
+
+    SUBSCRIBE2(block, handle_receive_block, _1, _2);
+    SUBSCRIBE2(not_found, handle_receive_not_found, _1, _2);
+
+    scheduler_->connect(nonce(), BIND1(send_requests, _1), BIND1(stop, _1));
+}
+
+// Protocol.
+// ----------------------------------------------------------------------------
+
+bool protocol_block_download_31402::handle_receive_block(const code& ec,
+    block_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    // The retained payload size avoids computing the serialized size.
+    const auto payload = get_wire_payload(message);
+    const auto size = payload != nullptr ? payload->data->size() :
+        message->serialized_size(negotiated_version());
+
+    scheduler_->received(nonce(), message->header().hash(), size);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_block_download_31402::handle_receive_not_found(const code& ec,
+    not_found_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    hash_list hashes;
+
+    for (const auto& item: message->inventories())
+        if (item.is_block_type())
+            hashes.push_back(item.hash());
+
+    if (!hashes.empty())
+        scheduler_->not_found(nonce(), hashes);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+void protocol_block_download_31402::send_requests(const hash_list& hashes)
+{
+    if (stopped())
+        return;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Requesting blocks from [" << authority() << "] ("
+        << hashes.size() << ")";
+
+    const get_data request(hashes, request_type_);
+    SEND2(request, handle_send, _1, request.command);
+}
+
+// The scheduler assigns in-flight blocks of the channel elsewhere.
+void protocol_block_download_31402::handle_stop(const code&)
+{
+    scheduler_->disconnect(nonce());
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,259 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_bloom_filter_70001.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/bloom_filter.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "bloom_filter"
+#define CLASS protocol_bloom_filter_70001
+
+using namespace bc::message;
+using namespace std::placeholders;
+
+typedef std::vector<hash_list> hash_tree;
+typedef std::vector<std::vector<bool>> flag_tree;
+
+// Depth first traversal of the merkle tree (bip37). The hash of a node is
+// included if it is a leaf or if no leaf below it matched.
+static void traverse(const hash_tree& hashes, const flag_tree& flags,
+    size_t height, size_t position, hash_list& out_hashes,
+    std::vector<bool>& out_flags)
+{
+    const auto parent = flags[height][position];
+    out_flags.push_back(parent);
+
+    if (height == 0 || !parent)
+    {
+        out_hashes.push_back(hashes[height][position]);
+        return;
+    }
+
+    const auto left = position * 2;
+    traverse(hashes, flags, height - 1, left, out_hashes, out_flags);
+
+    if (left + 1 < hashes[height - 1].size())
+        traverse(hashes, flags, height - 1, left + 1, out_hashes, out_flags);
+}
+
+// Build the partial merkle tree of the matched transactions of the block.
+static merkle_block to_merkle_block(const chain::block& block,
+    const std::vector<bool>& matches)
+{
+    const auto& transactions = block.transactions();
+    const auto count = transactions.size();
+
+    hash_tree hashes(1);
+    flag_tree flags(1, matches);
+    hashes.front().reserve(count);
+
+    for (const auto& tx: transactions)
+        hashes.front().push_back(tx.hash());
+
+    // An odd node is paired with itself.
+    while (hashes.back().size() > 1)
+    {
+        hash_list level;
+        std::vector<bool> matched;
+        const auto& below = hashes.back();
+        const auto& matched_below = flags.back();
+
+        for (size_t index = 0; index < below.size(); index += 2)
+        {
+            const auto pair = index + 1 < below.size();
+            const auto& right = pair ? below[index + 1] : below[index];
+            level.push_back(bitcoin_hash(build_chunk({ below[index], right })));
+            matched.push_back(matched_below[index] ||
+                (pair && matched_below[index + 1]));
+        }
+
+        hashes.push_back(std::move(level));
+        flags.push_back(std::move(matched));
+    }
+
+    hash_list out_hashes;
+    std::vector<bool> out_flags;
+
+    if (count != 0)
+        traverse(hashes, flags, hashes.size() - 1, 0, out_hashes, out_flags);
+
+    data_chunk bits((out_flags.size() + byte_bits - 1) / byte_bits, 0x00);
+
+    for (size_t bit = 0; bit < out_flags.size(); ++bit)
+        if (out_flags[bit])
+            bits[bit / byte_bits] |= (1 << (bit % byte_bits));
+
+    return merkle_block(block.header(), count, out_hashes, bits);
+}
+
+protocol_bloom_filter_70001::protocol_bloom_filter_70001(p2p& network,
+    channel::ptr channel)
+  : protocol_events(network, channel, NAME),
+    network_(network),
+    channel_(channel),
+    budget_(network.network_settings().bloom_filter_budget()),
+    CONSTRUCT_TRACK(protocol_bloom_filter_70001)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_bloom_filter_70001::start()
+{
+    protocol_events::start();
+
+    SUBSCRIBE2(filter_load, handle_receive_filter_load, _1, _2);
+    SUBSCRIBE2(filter_add, handle_receive_filter_add, _1, _2);
+    SUBSCRIBE2(filter_clear, handle_receive_filter_clear, _1, _2);
+    SUBSCRIBE2(get_data, handle_receive_get_data, _1, _2);
+}
+
+// Filter.
+// ----------------------------------------------------------------------------
+
+bool protocol_bloom_filter_70001::handle_receive_filter_load(const code& ec,
+    filter_load_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    if (!bloom_filter::valid(*message))
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Oversized filter from [" << authority() << "]";
+        stop(error::bad_stream);
+        return false;
+    }
+
+    channel_->set_filter(std::make_shared<bloom_filter>(*message, budget_));
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_bloom_filter_70001::handle_receive_filter_add(const code& ec,
+    filter_add_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto filter = channel_->filter();
+    const auto& data = message->data();
+
+    if (!filter || data.size() > bloom_filter::maximum_element_size)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Invalid filter add from [" << authority() << "]";
+        stop(error::bad_stream);
+        return false;
+    }
+
+    filter->insert(data);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_bloom_filter_70001::handle_receive_filter_clear(const code& ec,
+    filter_clear_const_ptr)
+{
+    if (stopped(ec))
+        return false;
+
+    channel_->set_filter(nullptr);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+// Filtered blocks.
+// ----------------------------------------------------------------------------
+
+bool protocol_bloom_filter_70001::handle_receive_get_data(const code& ec,
+    get_data_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    // Filtered blocks are not served without a filter.
+    const auto filter = channel_->filter();
+
+    if (!filter)
+        return true;
+
+    hash_list missing;
+
+    for (const auto& item: message->inventories())
+        if (item.type() == inventory::type_id::filtered_block &&
+            !send_merkle_block(item.hash(), filter))
+            missing.push_back(item.hash());
+
+    if (!missing.empty())
+    {
+        const not_found reply(missing, inventory::type_id::filtered_block);
+        SEND2(reply, handle_send, _1, reply.command);
+    }
+
+    // RESUBSCRIBE
+    return true;
+}
+
+// Send the merkle block followed by the matching transactions.
+bool protocol_bloom_filter_70001::send_merkle_block(const hash_digest& hash,
+    bloom_filter::ptr filter)
+{
+    const auto store = network_.block_store();
+    const auto block = store ? store->fetch(hash) : nullptr;
+    std::vector<bool> matches;
+
+    if (!block || !filter->matches(*block, matches))
+        return false;
+
+    const auto reply = to_merkle_block(*block, matches);
+    SEND2(reply, handle_send, _1, reply.command);
+
+    const auto& transactions = block->transactions();
+
+    for (size_t index = 0; index < transactions.size(); ++index)
+    {
+        if (matches[index])
+        {
+            const transaction tx(transactions[index]);
+            SEND2(tx, handle_send, _1, tx.command);
+        }
+    }
+
+    return true;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,571 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_compact_block_70014.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/compact_block_relay.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+#include <bitcoin/network/sip_hash.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "compact_block"
+#define CLASS protocol_compact_block_70014
+
+using namespace bc::chain;
+using namespace bc::message;
+using namespace std::placeholders;
+
+// Short transaction identifiers are the low 48 bits of the siphash.
+static constexpr uint64_t short_id_mask = 0x0000ffffffffffff;
+
+// Limit the number of blocks awaiting missing transactions from one peer.
+static constexpr size_t maximum_pending = 3;
+
+// Version 2 compact blocks identify transactions by witness hash.
+static uint64_t compact_version(const network::settings& settings,
+    version_const_ptr peer)
+{
+    const auto witness = version::service::node_witness;
+    return (settings.services & witness) != 0 && peer &&
+        (peer->services() & witness) != 0 ? 2 : 1;
+}
+
+// The siphash keys are the first two words of sha256(header || nonce).
+static std::pair<uint64_t, uint64_t> short_id_keys(const header& header,
+    uint64_t nonce)
+{
+    const auto digest = sha256_hash(build_chunk(
+    {
+        header.to_data(),
+        to_little_endian(nonce)
+    }));
+
+    return
+    {
+        from_little_endian_unsafe<uint64_t>(digest.begin()),
+        from_little_endian_unsafe<uint64_t>(digest.begin() + sizeof(uint64_t))
+    };
+}
+
+static uint64_t to_short_id(const mini_hash& id)
+{
+    uint64_t value = 0;
+
+    for (size_t byte = 0; byte < id.size(); ++byte)
+        value |= static_cast<uint64_t>(id[byte]) << (byte * 8);
+
+    return value;
+}
+
+static mini_hash to_mini_hash(uint64_t id)
+{
+    mini_hash value;
+
+    for (size_t byte = 0; byte < value.size(); ++byte)
+        value[byte] = static_cast<uint8_t>(id >> (byte * 8));
+
+    return value;
+}
+
+// Only the coinbase is prefilled, the peer is assumed to have the others.
+static compact_block to_compact_block(const block& block, bool witness)
+{
+    const auto& header = block.header();
+    const auto& transactions = block.transactions();
+    const auto nonce = pseudo_random(0, max_uint64);
+    const auto keys = short_id_keys(header, nonce);
+
+    compact_block::short_id_list short_ids;
+    short_ids.reserve(transactions.size() - 1);
+
+    for (auto tx = std::next(transactions.begin()); tx != transactions.end();
+        ++tx)
+        short_ids.push_back(to_mini_hash(sip_hash(keys.first, keys.second,
+            tx->hash(witness)) & short_id_mask));
+
+    const prefilled_transaction coinbase(0, transactions.front());
+    return compact_block(header, nonce, short_ids, { coinbase });
+}
+
+protocol_compact_block_70014::protocol_compact_block_70014(p2p& network,
+    channel::ptr channel, bool high_bandwidth)
+  : protocol_events(network, channel, NAME),
+    network_(network),
+    channel_(channel),
+    relay_(network.compact_blocks()),
+    high_bandwidth_(high_bandwidth),
+    compact_version_(compact_version(network.network_settings(),
+        channel->peer_version())),
+    selected_(false),
+    CONSTRUCT_TRACK(protocol_compact_block_70014)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_compact_block_70014::start()
+{
+    protocol_events::start(BIND1(handle_stop, _1));
+
+    SUBSCRIBE2(compact_block, handle_receive_compact_block, _1, _2);
+    SUBSCRIBE2(block_transactions, handle_receive_block_transactions, _1, _2);
+    SUBSCRIBE2(inventory, handle_receive_inventory, _1, _2);
+    SUBSCRIBE2(headers, handle_receive_headers, _1, _2);
+    SUBSCRIBE2(block, handle_receive_block, _1, _2);
+    SUBSCRIBE2(get_data, handle_receive_get_data, _1, _2);
+    SUBSCRIBE2(get_block_transactions, handle_receive_get_block_transactions,
+        _1, _2);
+
+    // High bandwidth peers are limited across all channels.
+    selected_ = high_bandwidth_ && relay_->select(nonce());
+    send_compact_request(selected_);
+}
+
+// Only the preferred version is announced, the peer ignores unsupported.
+void protocol_compact_block_70014::send_compact_request(bool high_bandwidth)
+{
+    const send_compact request(high_bandwidth, compact_version_);
+    SEND2(request, handle_send, _1, request.command);
+}
+
+// Announcement.
+// ----------------------------------------------------------------------------
+// A single new block is requested as a compact block, longer announcements
+// (such as during initial block download) are left to block download.
+
+bool protocol_compact_block_70014::handle_receive_inventory(const code& ec,
+    inventory_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    hash_list hashes;
+
+    for (const auto& item: message->inventories())
+        if (item.is_block_type())
+            hashes.push_back(item.hash());
+
+    if (hashes.size() == 1)
+        request_compact_block(hashes.front());
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_compact_block_70014::handle_receive_headers(const code& ec,
+    headers_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& elements = message->elements();
+
+    if (elements.size() == 1)
+        request_compact_block(elements.front().hash());
+
+    // RESUBSCRIBE
+    return true;
+}
+
+// A block delivered by any means completes the block.
+bool protocol_compact_block_70014::handle_receive_block(const code& ec,
+    block_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    relay_->completed(message->header().hash());
+
+    // RESUBSCRIBE
+    return true;
+}
+
+void protocol_compact_block_70014::request_compact_block(
+    const hash_digest& hash)
+{
+    if (stopped() || !relay_->claim(nonce(), hash))
+        return;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Requesting compact block " << encode_hash(hash) << " from ["
+        << authority() << "]";
+
+    const get_data request({ hash }, inventory::type_id::compact_block);
+    SEND2(request, handle_send, _1, request.command);
+}
+
+// Protocol.
+// ----------------------------------------------------------------------------
+
+bool protocol_compact_block_70014::handle_receive_compact_block(
+    const code& ec, compact_block_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& header = message->header();
+    const auto& short_ids = message->short_ids();
+    const auto& prefilled = message->transactions();
+    const auto count = short_ids.size() + prefilled.size();
+    const auto hash = header.hash();
+
+    if (count == 0)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Empty compact block from [" << authority() << "]";
+        stop(error::bad_stream);
+        return false;
+    }
+
+    // Another peer has delivered or is delivering the block.
+    if (!relay_->claim(nonce(), hash))
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Redundant compact block " << encode_hash(hash) << " from ["
+            << authority() << "]";
+        return true;
+    }
+
+    transaction::list transactions(count);
+    std::vector<bool> filled(count, false);
+
+    // Prefilled indexes are differentially encoded.
+    size_t index = 0;
+
+    for (const auto& tx: prefilled)
+    {
+        const auto offset = tx.index();
+
+        if (offset >= count || index + offset >= count)
+        {
+            LOG_DEBUG(LOG_NETWORK)
+                << "Invalid prefilled index in compact block from ["
+                << authority() << "]";
+            stop(error::bad_stream);
+            return false;
+        }
+
+        index += offset;
+        transactions[index] = tx.transaction();
+        filled[index] = true;
+        ++index;
+    }
+
+    // Map the short ids, in order, to the unfilled positions.
+    std::unordered_map<uint64_t, size_t> slots;
+    size_t slot = 0;
+
+    for (const auto& id: short_ids)
+    {
+        while (filled[slot])
+            ++slot;
+
+        // A short id collision within the block requires the full block.
+        if (!slots.emplace(to_short_id(id), slot++).second)
+        {
+            request_block(hash);
+            return true;
+        }
+    }
+
+    const auto pool = network_.transaction_pool();
+
+    if (!pool)
+    {
+        request_block(hash);
+        return true;
+    }
+
+    const auto witness = compact_version_ == 2;
+    const auto keys = short_id_keys(header, message->nonce());
+    std::vector<bool> ambiguous(count, false);
+    auto remaining = short_ids.size();
+
+    for (const auto& tx: pool->transactions())
+    {
+        const auto id = sip_hash(keys.first, keys.second, tx->hash(witness)) &
+            short_id_mask;
+
+        const auto it = slots.find(id);
+
+        if (it == slots.end() || ambiguous[it->second])
+            continue;
+
+        // Pool transactions that collide are requested from the peer.
+        if (filled[it->second])
+        {
+            transactions[it->second] = transaction{};
+            filled[it->second] = false;
+            ambiguous[it->second] = true;
+            ++remaining;
+            continue;
+        }
+
+        transactions[it->second] = *tx;
+        filled[it->second] = true;
+        --remaining;
+    }
+
+    if (remaining == 0)
+    {
+        complete(header, std::move(transactions));
+        return true;
+    }
+
+    std::vector<uint64_t> missing;
+    std::vector<uint64_t> indexes;
+    missing.reserve(remaining);
+    indexes.reserve(remaining);
+
+    // Requested indexes are differentially encoded.
+    for (size_t position = 0; position < count; ++position)
+    {
+        if (filled[position])
+            continue;
+
+        indexes.push_back(missing.empty() ? position :
+            position - missing.back() - 1);
+        missing.push_back(position);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    if (pending_.size() >= maximum_pending && pending_.count(hash) == 0)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        request_block(hash);
+        return true;
+    }
+
+    pending_[hash] = { header, std::move(transactions), std::move(missing) };
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Requesting " << remaining << " of " << count
+        << " compact block transactions from [" << authority() << "]";
+
+    const get_block_transactions request(hash, indexes);
+    SEND2(request, handle_send, _1, request.command);
+    return true;
+}
+
+bool protocol_compact_block_70014::handle_receive_block_transactions(
+    const code& ec, block_transactions_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& hash = message->block_hash();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto it = pending_.find(hash);
+
+    if (it == pending_.end())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        LOG_DEBUG(LOG_NETWORK)
+            << "Unrequested block transactions from [" << authority() << "]";
+        return true;
+    }
+
+    auto pending = std::move(it->second);
+    pending_.erase(it);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto& transactions = message->transactions();
+
+    if (transactions.size() != pending.missing.size())
+    {
+        request_block(hash);
+        return true;
+    }
+
+    for (size_t index = 0; index < transactions.size(); ++index)
+        pending.transactions[pending.missing[index]] = transactions[index];
+
+    complete(pending.header, std::move(pending.transactions));
+    return true;
+}
+
+// Completion.
+// ----------------------------------------------------------------------------
+
+// A short id collision with a pool transaction results in a bad merkle root.
+void protocol_compact_block_70014::complete(const header& header,
+    transaction::list&& transactions)
+{
+    const auto block = std::make_shared<const message::block>(header,
+        std::move(transactions));
+
+    if (block->generate_merkle_root() != header.merkle())
+    {
+        request_block(header.hash());
+        return;
+    }
+
+    relay_->completed(header.hash());
+    channel_->deliver(block);
+
+    // A peer that delivers blocks is preferred for high bandwidth relay.
+    if (high_bandwidth_ && !selected_ && relay_->select(nonce()) &&
+        !selected_.exchange(true))
+        send_compact_request(true);
+}
+
+void protocol_compact_block_70014::request_block(const hash_digest& hash)
+{
+    if (stopped())
+        return;
+
+    const auto type = compact_version_ == 2 ?
+        inventory::type_id::witness_block : inventory::type_id::block;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Requesting full block " << encode_hash(hash) << " from ["
+        << authority() << "]";
+
+    const get_data request({ hash }, type);
+    SEND2(request, handle_send, _1, request.command);
+}
+
+// Serving.
+// ----------------------------------------------------------------------------
+
+bool protocol_compact_block_70014::handle_receive_get_data(const code& ec,
+    get_data_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    hash_list missing;
+
+    for (const auto& item: message->inventories())
+        if (item.type() == inventory::type_id::compact_block &&
+            !send_compact_block(item.hash()))
+            missing.push_back(item.hash());
+
+    if (!missing.empty())
+    {
+        const not_found reply(missing, inventory::type_id::compact_block);
+        SEND2(reply, handle_send, _1, reply.command);
+    }
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_compact_block_70014::send_compact_block(const hash_digest& hash)
+{
+    const auto store = network_.block_store();
+    const auto block = store ? store->fetch(hash) : nullptr;
+
+    if (!block || block->transactions().empty())
+        return false;
+
+    const auto reply = to_compact_block(*block, compact_version_ == 2);
+    SEND2(reply, handle_send, _1, reply.command);
+    return true;
+}
+
+// Requested indexes are differentially encoded.
+bool protocol_compact_block_70014::handle_receive_get_block_transactions(
+    const code& ec, get_block_transactions_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& hash = message->block_hash();
+    const auto store = network_.block_store();
+    const auto block = store ? store->fetch(hash) : nullptr;
+
+    if (!block)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Block transactions requested for unknown block "
+            << encode_hash(hash) << " from [" << authority() << "]";
+        return true;
+    }
+
+    const auto& transactions = block->transactions();
+    transaction::list requested;
+    requested.reserve(message->indexes().size());
+    size_t position = 0;
+
+    for (const auto offset: message->indexes())
+    {
+        if (offset >= transactions.size() ||
+            position + offset >= transactions.size())
+        {
+            LOG_DEBUG(LOG_NETWORK)
+                << "Invalid block transaction index from [" << authority()
+                << "]";
+            stop(error::bad_stream);
+            return false;
+        }
+
+        position += offset;
+        requested.push_back(transactions[position++]);
+    }
+
+    const block_transactions reply(hash, requested);
+    SEND2(reply, handle_send, _1, reply.command);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+void protocol_compact_block_70014::handle_stop(const code&)
+{
+    relay_->disconnect(nonce());
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    pending_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_fee_filter_70013.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol_timer.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "fee_filter"
+#define CLASS protocol_fee_filter_70013
+
+using namespace bc::message;
+using namespace std::placeholders;
+
+// The fee floor is checked for change on a randomized interval.
+static const asio::duration fee_filter_interval = asio::seconds(300);
+
+// Fee floors are rounded down to a bucket of ten percent fee rate spacing.
+static const double bucket_spacing = 1.1;
+
+protocol_fee_filter_70013::protocol_fee_filter_70013(p2p& network,
+    channel::ptr channel)
+  : protocol_timer(network, channel, true, NAME),
+    network_(network),
+    channel_(channel),
+    floor_(0),
+    CONSTRUCT_TRACK(protocol_fee_filter_70013)
+{
+}
+
+// Fee rates.
+// ----------------------------------------------------------------------------
+
+// The fee floor must change by more than a third to be resent.
+bool protocol_fee_filter_70013::changed(uint64_t previous, uint64_t current)
+{
+    return current * 4 < previous * 3 || current * 3 > previous * 4;
+}
+
+// Rounding to a lower bucket (at random) obscures the local fee floor.
+uint64_t protocol_fee_filter_70013::round_fee(uint64_t fee_rate)
+{
+    if (fee_rate == 0)
+        return 0;
+
+    auto bucket = std::floor(std::log(static_cast<double>(fee_rate)) /
+        std::log(bucket_spacing));
+
+    if (bucket > 0 && pseudo_random(0, 2) != 0)
+        --bucket;
+
+    return static_cast<uint64_t>(std::pow(bucket_spacing, bucket));
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_fee_filter_70013::start()
+{
+    protocol_timer::start(pseudo_randomize(fee_filter_interval),
+        BIND1(send_fee_filter, _1));
+
+    SUBSCRIBE2(fee_filter, handle_receive_fee_filter, _1, _2);
+
+    // Send initial fee filter message by simulating first timer event.
+    set_event(error::success);
+}
+
+// Outbound.
+// ----------------------------------------------------------------------------
+
+// This is fired by the callback (i.e. base timer and stop handler).
+// The floor value is protected by the timer suspension during the handler.
+void protocol_fee_filter_70013::send_fee_filter(const code& ec)
+{
+    if (stopped(ec))
+        return;
+
+    if (ec && ec != error::channel_timeout)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure in fee filter timer for [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return;
+    }
+
+    const auto floor = network_.fee_floor();
+
+    if (!changed(floor_, floor))
+        return;
+
+    floor_ = floor;
+    SEND2(fee_filter{ round_fee(floor) }, handle_send, _1,
+        fee_filter::command);
+}
+
+// Inbound.
+// ----------------------------------------------------------------------------
+
+bool protocol_fee_filter_70013::handle_receive_fee_filter(const code& ec,
+    fee_filter_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto minimum = message->minimum_fee();
+
+    if (minimum > max_money())
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Invalid fee filter (" << minimum << ") from ["
+            << authority() << "]";
+        stop(error::bad_stream);
+        return false;
+    }
+
+    channel_->set_fee_filter(minimum);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+} // namespace network
+} // namespace libbitcoin
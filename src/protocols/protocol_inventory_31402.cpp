@@ -0,0 +1,345 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_inventory_31402.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "inventory"
+#define CLASS protocol_inventory_31402
+
+using namespace bc::message;
+using namespace std::placeholders;
+
+// Hashes known to the peer are retained for at least the most recent 25000.
+static const size_t known_inventory = 25000;
+static const double known_false_positive_rate = 0.000001;
+
+// Bound the queue between trickles (to bound memory), later items are dropped.
+static const size_t maximum_pending = max_inventory;
+
+// The peer does not want transaction announcements (bip37).
+static bool relay_transactions(version_const_ptr peer)
+{
+    return !peer || peer->value() < version::level::bip37 || peer->relay();
+}
+
+// Transactions not flooded to a reconciling peer await reconciliation (erlay).
+static bool reconciled(reconciliation_set::ptr set, const hash_digest& hash)
+{
+    return set && !set->flood(hash) && set->insert(hash);
+}
+
+protocol_inventory_31402::protocol_inventory_31402(p2p& network,
+    channel::ptr channel, bool transactions)
+  : protocol_events(network, channel, NAME),
+    network_(network),
+    channel_(channel),
+    relay_(transactions && relay_transactions(channel->peer_version())),
+    trickle_(network.network_settings().channel_trickle()),
+    timer_(std::make_shared<deadline>(network.thread_pool(), trickle_)),
+    known_(known_inventory, known_false_positive_rate),
+    CONSTRUCT_TRACK(protocol_inventory_31402)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_inventory_31402::start()
+{
+    protocol_events::start(BIND1(handle_stop, _1));
+
+    SUBSCRIBE2(inventory, handle_receive_inventory, _1, _2);
+    SUBSCRIBE2(transaction, handle_receive_transaction, _1, _2);
+    channel_->subscribe_announcement(BIND3(handle_announce, _1, _2, _3));
+    channel_->subscribe_transaction_announcement(
+        BIND3(handle_announce_transaction, _1, _2, _3));
+
+    // Header announcements are handled by protocol_send_headers if attached.
+    if (!network_.network_settings().send_headers ||
+        negotiated_version() < version::level::bip130)
+        channel_->subscribe_header_announcement(
+            BIND2(handle_announce_headers, _1, _2));
+
+    start_trickle();
+}
+
+// Known inventory.
+// ----------------------------------------------------------------------------
+
+void protocol_inventory_31402::set_known(const hash_digest& hash)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    known_.insert(hash);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool protocol_inventory_31402::handle_receive_inventory(const code& ec,
+    inventory_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& item: message->inventories())
+        known_.insert(item.hash());
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_inventory_31402::handle_receive_transaction(const code& ec,
+    transaction_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    set_known(message->hash());
+
+    // RESUBSCRIBE
+    return true;
+}
+
+// Announcement.
+// ----------------------------------------------------------------------------
+
+bool protocol_inventory_31402::handle_announce(const code& ec,
+    inventory_const_ptr message, uint64_t fee_rate)
+{
+    if (stopped(ec))
+        return false;
+
+    // Transactions below the peer fee filter are dropped before queueing.
+    // Transaction hashes cannot be matched to a peer filter, so are dropped.
+    const auto relay = relay_ && !channel_->filter() &&
+        (fee_rate == 0 || fee_rate >= channel_->fee_filter());
+
+    const auto reconciliation = channel_->reconciliation();
+    size_t dropped = 0;
+    list blocks;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& item: message->inventories())
+    {
+        if (known_.contains(item.hash()))
+            continue;
+
+        if (item.is_block_type())
+        {
+            known_.insert(item.hash());
+            blocks.push_back(item);
+        }
+        else if (!item.is_transaction_type() || relay)
+        {
+            if (item.is_transaction_type() &&
+                reconciled(reconciliation, item.hash()))
+                known_.insert(item.hash());
+            else if (pending_.size() < maximum_pending)
+            {
+                known_.insert(item.hash());
+                pending_.push_back(item);
+            }
+            else
+                ++dropped;
+        }
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (dropped != 0)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Dropped (" << dropped << ") announcements to ["
+            << authority() << "] in excess of the trickle queue limit.";
+
+    // Block announcement latency matters to propagation, so don't trickle.
+    if (!blocks.empty())
+        send_inventory(std::move(blocks));
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_inventory_31402::handle_announce_transaction(const code& ec,
+    transaction_const_ptr message, uint64_t fee_rate)
+{
+    if (stopped(ec))
+        return false;
+
+    // A peer filter enables relay of matching transactions (bip37).
+    const auto filter = channel_->filter();
+    if (filter ? !filter->matches(*message) : !relay_)
+        return true;
+
+    if (fee_rate != 0 && fee_rate < channel_->fee_filter())
+        return true;
+
+    const auto hash = message->hash();
+    const auto reconciliation = channel_->reconciliation();
+    auto dropped = false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    if (!known_.contains(hash))
+    {
+        if (reconciled(reconciliation, hash))
+            known_.insert(hash);
+        else if (pending_.size() < maximum_pending)
+        {
+            known_.insert(hash);
+            pending_.push_back({ inventory::type_id::transaction, hash });
+        }
+        else
+            dropped = true;
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (dropped)
+        LOG_DEBUG(LOG_NETWORK)
+            << "Dropped transaction announcement to [" << authority()
+            << "] in excess of the trickle queue limit.";
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_inventory_31402::handle_announce_headers(const code& ec,
+    headers_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    list blocks;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& header: message->elements())
+    {
+        const auto hash = header.hash();
+
+        if (!known_.contains(hash))
+        {
+            known_.insert(hash);
+            blocks.push_back({ inventory::type_id::block, hash });
+        }
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!blocks.empty())
+        send_inventory(std::move(blocks));
+
+    // RESUBSCRIBE
+    return true;
+}
+
+// Trickle.
+// ----------------------------------------------------------------------------
+
+void protocol_inventory_31402::start_trickle()
+{
+    if (stopped())
+        return;
+
+    // Randomization obscures the origin of announcements across channels.
+    timer_->start(BIND1(handle_trickle, _1), pseudo_randomize(trickle_));
+}
+
+void protocol_inventory_31402::handle_trickle(const code& ec)
+{
+    if (stopped())
+        return;
+
+    list items;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    items.swap(pending_);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!items.empty())
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Announcing inventory to [" << authority() << "] ("
+            << items.size() << ")";
+
+        send_inventory(std::move(items));
+    }
+
+    start_trickle();
+}
+
+void protocol_inventory_31402::send_inventory(list&& items)
+{
+    for (auto it = items.begin(); it != items.end();)
+    {
+        const auto count = std::min<size_t>(max_inventory,
+            std::distance(it, items.end()));
+        const inventory batch{ list(std::make_move_iterator(it),
+            std::make_move_iterator(it + count)) };
+
+        SEND2(batch, handle_send, _1, batch.command);
+        it += count;
+    }
+}
+
+void protocol_inventory_31402::handle_stop(const code&)
+{
+    timer_->stop();
+}
+
+} // namespace network
+} // namespace libbitcoin
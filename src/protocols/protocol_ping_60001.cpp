@@ -38,7 +38,9 @@ using namespace std::placeholders;
 
 protocol_ping_60001::protocol_ping_60001(p2p& network, channel::ptr channel)
   : protocol_ping_31402(network, channel),
+    channel_(channel),
     pending_(false),
+    sent_(asio::steady_clock::now()),
     CONSTRUCT_TRACK(protocol_ping_60001)
 {
 }
@@ -67,6 +69,7 @@ void protocol_ping_60001::send_ping(const code& ec)
     }
 
     pending_ = true;
+    sent_.store(asio::steady_clock::now());
     const auto nonce = pseudo_random();
     SUBSCRIBE3(pong, handle_receive_pong, _1, _2, nonce);
     SEND2(ping{ nonce }, handle_send_ping, _1, ping::command);
@@ -131,6 +134,7 @@ bool protocol_ping_60001::handle_receive_pong(const code& ec,
         return false;
     }
 
+    channel_->set_latency(asio::steady_clock::now() - sent_.load());
     return false;
 }
 
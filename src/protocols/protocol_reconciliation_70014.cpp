@@ -0,0 +1,359 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_reconciliation_70014.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/pin_sketch.hpp>
+#include <bitcoin/network/protocols/protocol_timer.hpp>
+#include <bitcoin/network/reconciliation_set.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "reconciliation"
+#define CLASS protocol_reconciliation_70014
+
+using namespace bc::message;
+using namespace std::placeholders;
+
+// Messages (after bip330), which are not defined by the message library.
+// These are not bip330 compatible (registration follows verack and the
+// difference is of short ids), so bip330 command names are not used.
+static const std::string register_command = "rcnlregister";
+static const std::string request_command = "rcnlrequest";
+static const std::string sketch_command = "rcnlsketch";
+static const std::string difference_command = "rcnldiff";
+
+static const uint32_t reconciliation_version = 1;
+
+// Sketch capacity is estimated as |local - remote| + q * min + 1.
+static const double estimator = 0.25;
+static const double estimator_scale = 32767.0;
+
+// Decoding cost is quadratic in capacity, larger differences fail over.
+static const size_t maximum_capacity = 256;
+
+static size_t capacity(size_t local, size_t remote, double q)
+{
+    const auto difference = std::max(local, remote) - std::min(local, remote);
+    const auto common = static_cast<size_t>(q * std::min(local, remote));
+    return std::min(difference + common + 1, maximum_capacity);
+}
+
+protocol_reconciliation_70014::protocol_reconciliation_70014(p2p& network,
+    channel::ptr channel, bool initiator)
+  : protocol_timer(network, channel, true, NAME),
+    network_(network),
+    channel_(channel),
+    initiator_(initiator),
+    salt_(pseudo_random(0, max_uint64)),
+    flood_rate_(initiator ?
+        std::min(1.0, static_cast<double>(
+            network.network_settings().reconciliation_fanout) /
+            std::max(1u, network.network_settings().outbound_connections)) :
+        0.0),
+    pending_(false),
+    CONSTRUCT_TRACK(protocol_reconciliation_70014)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_reconciliation_70014::start()
+{
+    const auto& settings = network_.network_settings();
+
+    // Only the initiator requests reconciliation on a timer.
+    if (initiator_)
+        protocol_timer::start(settings.reconciliation_interval(),
+            BIND1(send_request, _1));
+    else
+        protocol_events::start();
+
+    for (const auto& command: { register_command, request_command,
+        sketch_command, difference_command })
+        channel_->set_pass_through(command, true);
+
+    channel_->subscribe_raw(BIND3(handle_receive, _1, _2, _3));
+
+    data_chunk payload;
+    data_sink ostream(payload);
+    ostream_writer sink(ostream);
+    sink.write_4_bytes_little_endian(reconciliation_version);
+    sink.write_8_bytes_little_endian(salt_);
+    ostream.flush();
+
+    send_message(register_command, std::move(payload));
+}
+
+// Inbound.
+// ----------------------------------------------------------------------------
+
+bool protocol_reconciliation_70014::handle_receive(const code& ec,
+    const heading& head, proxy::data_ptr payload)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& command = head.command();
+
+    if (command == register_command)
+        handle_register(*payload);
+    else if (command == request_command)
+        handle_request(*payload);
+    else if (command == sketch_command)
+        handle_sketch(*payload);
+    else if (command == difference_command)
+        handle_difference(*payload);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+void protocol_reconciliation_70014::handle_register(const data_chunk& payload)
+{
+    data_source istream(payload);
+    istream_reader source(istream);
+    const auto version = source.read_4_bytes_little_endian();
+    const auto salt = source.read_8_bytes_little_endian();
+
+    if (!source || version < reconciliation_version ||
+        channel_->reconciliation())
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Invalid " << register_command << " from [" << authority()
+            << "]";
+        stop(error::bad_stream);
+        return;
+    }
+
+    channel_->set_reconciliation(std::make_shared<reconciliation_set>(salt_,
+        salt, flood_rate_));
+}
+
+// Responder, sketch the set at the capacity estimated by the initiator.
+void protocol_reconciliation_70014::handle_request(const data_chunk& payload)
+{
+    const auto set = channel_->reconciliation();
+    data_source istream(payload);
+    istream_reader source(istream);
+    const auto remote = source.read_2_bytes_little_endian();
+    const auto q = source.read_2_bytes_little_endian() / estimator_scale;
+
+    if (!source || !set || initiator_)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Invalid " << request_command << " from [" << authority()
+            << "]";
+        stop(error::bad_stream);
+        return;
+    }
+
+    const auto local = set->snapshot();
+    const auto sketch = set->sketch(capacity(local, remote, q)).to_data();
+
+    data_chunk reply;
+    data_sink ostream(reply);
+    ostream_writer sink(ostream);
+    sink.write_variable_little_endian(sketch.size());
+    sink.write_bytes(sketch);
+    ostream.flush();
+
+    send_message(sketch_command, std::move(reply));
+}
+
+// Initiator, decode the difference of the sets.
+void protocol_reconciliation_70014::handle_sketch(const data_chunk& payload)
+{
+    const auto set = channel_->reconciliation();
+    data_source istream(payload);
+    istream_reader source(istream);
+    const auto size = source.read_variable_little_endian();
+    const auto data = source.read_bytes(static_cast<size_t>(std::min<uint64_t>(
+        size, maximum_capacity * sizeof(uint32_t))));
+
+    if (!source || !set || !initiator_ ||
+        size % sizeof(uint32_t) != 0 || size != data.size())
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Invalid " << sketch_command << " from [" << authority()
+            << "]";
+        stop(error::bad_stream);
+        return;
+    }
+
+    // The reconciliation was abandoned by the timer (see send_request).
+    if (!pending_.exchange(false))
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Ignoring late " << sketch_command << " from ["
+            << authority() << "]";
+        return;
+    }
+
+    pin_sketch sketch(data);
+    auto local = set->sketch(sketch.capacity());
+    reconciliation_set::short_ids difference;
+
+    const auto success = sketch.capacity() != 0 && local.merge(sketch) &&
+        local.decode(difference);
+
+    reconciliation_set::short_ids missing;
+    const auto hashes = success ? set->complete(difference, missing) :
+        set->complete();
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Reconciliation with [" << authority() << "] "
+        << (success ? "succeeded" : "failed") << " (" << hashes.size()
+        << " sent, " << missing.size() << " requested)";
+
+    data_chunk reply;
+    data_sink ostream(reply);
+    ostream_writer sink(ostream);
+    sink.write_byte(success ? 1 : 0);
+    sink.write_variable_little_endian(missing.size());
+
+    for (const auto id: missing)
+        sink.write_4_bytes_little_endian(id);
+
+    ostream.flush();
+
+    send_message(difference_command, std::move(reply));
+    announce(hashes);
+}
+
+// Responder, announce the requested transactions or all upon failure.
+void protocol_reconciliation_70014::handle_difference(
+    const data_chunk& payload)
+{
+    const auto set = channel_->reconciliation();
+    data_source istream(payload);
+    istream_reader source(istream);
+    const auto success = source.read_byte() != 0;
+    const auto count = source.read_variable_little_endian();
+    reconciliation_set::short_ids ids;
+
+    if (source && count <= maximum_capacity)
+    {
+        ids.reserve(static_cast<size_t>(count));
+
+        for (size_t id = 0; id < count && source; ++id)
+            ids.push_back(source.read_4_bytes_little_endian());
+    }
+
+    if (!source || !set || initiator_ || count > maximum_capacity)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Invalid " << difference_command << " from [" << authority()
+            << "]";
+        stop(error::bad_stream);
+        return;
+    }
+
+    reconciliation_set::short_ids missing;
+    announce(success ? set->complete(ids, missing) : set->complete());
+}
+
+// Outbound.
+// ----------------------------------------------------------------------------
+
+// This is fired by the callback (i.e. base timer and stop handler).
+void protocol_reconciliation_70014::send_request(const code& ec)
+{
+    if (stopped(ec))
+        return;
+
+    if (ec && ec != error::channel_timeout)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Failure in reconciliation timer for [" << authority() << "] "
+            << ec.message();
+        stop(ec);
+        return;
+    }
+
+    const auto set = channel_->reconciliation();
+
+    if (!set)
+        return;
+
+    // One reconciliation at a time, one not completed by the next interval
+    // is abandoned and its snapshot announced in full (as upon failure).
+    if (pending_.exchange(true))
+    {
+        const auto hashes = set->complete();
+
+        LOG_DEBUG(LOG_NETWORK)
+            << "Reconciliation with [" << authority() << "] timed out ("
+            << hashes.size() << " sent)";
+
+        pending_ = false;
+        announce(hashes);
+        return;
+    }
+
+    const auto local = std::min<size_t>(set->snapshot(), max_uint16);
+
+    data_chunk payload;
+    data_sink ostream(payload);
+    ostream_writer sink(ostream);
+    sink.write_2_bytes_little_endian(static_cast<uint16_t>(local));
+    sink.write_2_bytes_little_endian(
+        static_cast<uint16_t>(estimator * estimator_scale));
+    ostream.flush();
+
+    send_message(request_command, std::move(payload));
+}
+
+void protocol_reconciliation_70014::send_message(const std::string& command,
+    data_chunk&& payload)
+{
+    const auto data = std::make_shared<const data_chunk>(std::move(payload));
+    channel_->send_raw(command, data, bitcoin_checksum(*data),
+        BIND2(handle_send, _1, command));
+}
+
+void protocol_reconciliation_70014::announce(const hash_list& hashes)
+{
+    for (auto it = hashes.begin(); it != hashes.end();)
+    {
+        const auto count = std::min<size_t>(max_inventory,
+            std::distance(it, hashes.end()));
+        const inventory batch(hash_list(it, it + count),
+            inventory::type_id::transaction);
+
+        SEND2(batch, handle_send, _1, batch.command);
+        it += count;
+    }
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,217 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_send_headers_70012.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "send_headers"
+#define CLASS protocol_send_headers_70012
+
+using namespace bc::message;
+using namespace std::placeholders;
+
+// Blocks known to the peer are retained for at least the most recent 10000.
+static const size_t known_blocks = 10000;
+static const double known_false_positive_rate = 0.000001;
+
+// Longer announcements (reorganizations) fall back to inventory.
+static const size_t maximum_announcement = 8;
+
+protocol_send_headers_70012::protocol_send_headers_70012(p2p& network,
+    channel::ptr channel)
+  : protocol_events(network, channel, NAME),
+    network_(network),
+    channel_(channel),
+    headers_(false),
+    known_(known_blocks, known_false_positive_rate),
+    CONSTRUCT_TRACK(protocol_send_headers_70012)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_send_headers_70012::start()
+{
+    protocol_events::start();
+
+    SUBSCRIBE2(send_headers, handle_receive_send_headers, _1, _2);
+    SUBSCRIBE2(headers, handle_receive_headers, _1, _2);
+    SUBSCRIBE2(inventory, handle_receive_inventory, _1, _2);
+    channel_->subscribe_header_announcement(BIND2(handle_announce, _1, _2));
+
+    SEND2(send_headers{}, handle_send, _1, send_headers::command);
+}
+
+// Inbound.
+// ----------------------------------------------------------------------------
+
+bool protocol_send_headers_70012::handle_receive_send_headers(const code& ec,
+    send_headers_const_ptr)
+{
+    if (stopped(ec))
+        return false;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Peer [" << authority() << "] requested header announcements.";
+
+    headers_ = true;
+
+    // The peer preference cannot be revoked.
+    return false;
+}
+
+bool protocol_send_headers_70012::handle_receive_headers(const code& ec,
+    headers_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& elements = message->elements();
+
+    if (elements.empty())
+        return true;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& header: elements)
+        known_.insert(header.hash());
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    channel_->set_best_known_header(elements.back().hash());
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_send_headers_70012::handle_receive_inventory(const code& ec,
+    inventory_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    auto best = null_hash;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto& item: message->inventories())
+    {
+        if (item.is_block_type())
+        {
+            known_.insert(item.hash());
+            best = item.hash();
+        }
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (best != null_hash)
+        channel_->set_best_known_header(best);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+// Announcement.
+// ----------------------------------------------------------------------------
+
+bool protocol_send_headers_70012::handle_announce(const code& ec,
+    headers_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& elements = message->elements();
+    const auto best = channel_->best_known_header();
+    chain::header::list announce;
+    auto connected = false;
+
+    // The peer knows its best known header (such as the last sent in reply
+    // to get_headers) and so all of the headers that precede it.
+    auto it = std::find_if(elements.begin(), elements.end(),
+        [&best](const chain::header& header)
+        {
+            return header.hash() == best;
+        });
+
+    it = it == elements.end() ? elements.begin() : std::next(it);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    // Skip the leading headers already known to the peer.
+    while (it != elements.end() && known_.contains(it->hash()))
+        ++it;
+
+    if (it != elements.end())
+    {
+        const auto& previous = it->previous_block_hash();
+        connected = previous == best || known_.contains(previous);
+        announce.assign(it, elements.end());
+
+        for (const auto& header: announce)
+            known_.insert(header.hash());
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (announce.empty())
+        return true;
+
+    const auto top = announce.back().hash();
+    channel_->set_best_known_header(top);
+
+    // The peer cannot connect headers to a block it does not know.
+    if (headers_ && connected && announce.size() <= maximum_announcement)
+    {
+        const headers reply(announce);
+        SEND2(reply, handle_send, _1, reply.command);
+    }
+    else
+    {
+        const inventory reply({ top }, inventory::type_id::block);
+        SEND2(reply, handle_send, _1, reply.command);
+    }
+
+    // RESUBSCRIBE
+    return true;
+}
+
+} // namespace network
+} // namespace libbitcoin
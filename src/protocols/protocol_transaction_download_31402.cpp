@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/protocols/protocol_transaction_download_31402.hpp>
+
+#include <functional>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/channel.hpp>
+#include <bitcoin/network/define.hpp>
+#include <bitcoin/network/p2p.hpp>
+#include <bitcoin/network/protocols/protocol.hpp>
+#include <bitcoin/network/protocols/protocol_events.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define NAME "transaction_download"
+#define CLASS protocol_transaction_download_31402
+
+using namespace bc::message;
+using namespace std::placeholders;
+
+// Request witness transactions if both we and the peer support witness.
+static inventory::type_id request_type(const network::settings& settings,
+    version_const_ptr peer)
+{
+    const auto witness = version::service::node_witness;
+    return (settings.services & witness) != 0 && peer &&
+        (peer->services() & witness) != 0 ?
+            inventory::type_id::witness_transaction :
+            inventory::type_id::transaction;
+}
+
+static hash_list transaction_hashes(const inventory_vector::list& items)
+{
+    hash_list hashes;
+    hashes.reserve(items.size());
+
+    for (const auto& item: items)
+        if (item.is_transaction_type())
+            hashes.push_back(item.hash());
+
+    return hashes;
+}
+
+protocol_transaction_download_31402::protocol_transaction_download_31402(
+    p2p& network, channel::ptr channel)
+  : protocol_events(network, channel, NAME),
+    network_(network),
+    scheduler_(network.transaction_downloads()),
+    request_type_(request_type(network.network_settings(),
+        channel->peer_version())),
+    CONSTRUCT_TRACK(protocol_transaction_download_31402)
+{
+}
+
+// Start sequence.
+// ----------------------------------------------------------------------------
+
+void protocol_transaction_download_31402::start()
+{
+    protocol_events::start(BIND1(handle_stop, _1));
+
+    scheduler_->connect(nonce(), BIND1(send_requests, _1));
+
+    SUBSCRIBE2(inventory, handle_receive_inventory, _1, _2);
+    SUBSCRIBE2(transaction, handle_receive_transaction, _1, _2);
+    SUBSCRIBE2(not_found, handle_receive_not_found, _1, _2);
+}
+
+// Protocol.
+// ----------------------------------------------------------------------------
+
+bool protocol_transaction_download_31402::handle_receive_inventory(
+    const code& ec, inventory_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto hashes = transaction_hashes(message->inventories());
+
+    if (!hashes.empty())
+        scheduler_->announced(nonce(), hashes);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_transaction_download_31402::handle_receive_transaction(
+    const code& ec, transaction_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    scheduler_->received(nonce(), message->hash());
+
+    // RESUBSCRIBE
+    return true;
+}
+
+bool protocol_transaction_download_31402::handle_receive_not_found(
+    const code& ec, not_found_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto hashes = transaction_hashes(message->inventories());
+
+    if (!hashes.empty())
+        scheduler_->not_found(nonce(), hashes);
+
+    // RESUBSCRIBE
+    return true;
+}
+
+void protocol_transaction_download_31402::send_requests(
+    const hash_list& hashes)
+{
+    if (stopped())
+        return;
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Requesting transactions from [" << authority() << "] ("
+        << hashes.size() << ")";
+
+    const get_data request(hashes, request_type_);
+    SEND2(request, handle_send, _1, request.command);
+}
+
+// The scheduler requests in-flight transactions of the channel elsewhere.
+void protocol_transaction_download_31402::handle_stop(const code&)
+{
+    scheduler_->disconnect(nonce());
+}
+
+} // namespace network
+} // namespace libbitcoin
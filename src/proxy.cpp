@@ -21,12 +21,16 @@
 #define BOOST_BIND_NO_PLACEHOLDERS
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <iterator>
+#include <string>
 #include <utility>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/define.hpp>
 #include <bitcoin/network/settings.hpp>
@@ -43,6 +47,9 @@ using namespace bc::message;
 // Dump up to 1k of payload as hex in order to diagnose failure.
 static const size_t invalid_payload_dump_size = 1024;
 
+// Read streamed block payloads in pieces of up to 64k.
+static const size_t block_chunk_size = 65536;
+
 // payload_buffer_ sizing assumes monotonically increasing size by version.
 // Initialize to pre-witness max payload and let grow to witness as required.
 // The socket owns the single thread on which this channel reads and writes.
@@ -54,13 +61,27 @@ proxy::proxy(threadpool& pool, socket::ptr socket, const settings& settings)
         (settings.services & version::service::node_witness) != 0)),
     socket_(socket),
     stopped_(true),
+    paused_(false),
+    backlog_(0),
+    backlog_limit_(settings.read_backlog_limit),
     protocol_magic_(settings.identifier),
     validate_checksum_(settings.validate_checksum),
+    stream_blocks_(settings.stream_blocks && !settings.validate_checksum &&
+        !settings.retain_payloads),
+    retain_payloads_(settings.retain_payloads),
+    prioritize_sends_(settings.prioritize_sends),
     verbose_(settings.verbose),
     version_(settings.protocol_maximum),
     message_subscriber_(pool),
     stop_subscriber_(std::make_shared<stop_subscriber>(pool, NAME "_sub")),
-    dispatch_(pool, NAME "_dispatch")
+    block_stream_subscriber_(std::make_shared<block_stream_subscriber>(pool,
+        NAME "_block_stream_sub")),
+    raw_subscriber_(std::make_shared<raw_subscriber>(pool, NAME "_raw_sub")),
+    sending_(false),
+    shaping_(false),
+    granted_(false),
+    sequence_(0),
+    send_bytes_{ { 0, 0, 0 } }
 {
 }
 
@@ -100,6 +121,8 @@ void proxy::start(result_handler handler)
 
     stopped_ = false;
     stop_subscriber_->start();
+    block_stream_subscriber_->start();
+    raw_subscriber_->start();
     message_subscriber_.start();
 
     // Allow for subscription before first read, so no messages are missed.
@@ -117,6 +140,74 @@ void proxy::subscribe_stop(result_handler handler)
     stop_subscriber_->subscribe(handler, error::channel_stopped);
 }
 
+// Pass-through.
+// ----------------------------------------------------------------------------
+
+void proxy::subscribe_raw(raw_handler handler)
+{
+    raw_subscriber_->subscribe(handler, error::channel_stopped, {}, {});
+}
+
+void proxy::set_pass_through(const std::string& command, bool enabled)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(pass_through_mutex_);
+
+    if (enabled)
+        pass_through_.insert(command);
+    else
+        pass_through_.erase(command);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool proxy::pass_through(const std::string& command) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(pass_through_mutex_);
+
+    return pass_through_.find(command) != pass_through_.end();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Delivery policy.
+// ----------------------------------------------------------------------------
+
+void proxy::set_delivery_policy(message_type type, delivery policy)
+{
+    message_subscriber_.set_delivery_policy(type, policy);
+}
+
+void proxy::set_dedicated_pool(threadpool& pool)
+{
+    message_subscriber_.set_dedicated_pool(pool);
+}
+
+// Upload shaping.
+// ----------------------------------------------------------------------------
+
+void proxy::set_upload_shaper(upload_shaper::ptr shaper)
+{
+    shaper_ = shaper;
+    flow_ = shaper->open();
+}
+
+void proxy::set_upload_rate(size_t bytes_per_second)
+{
+    if (shaper_)
+        shaper_->set_rate(flow_, bytes_per_second);
+}
+
+// Block stream subscription.
+// ----------------------------------------------------------------------------
+
+void proxy::subscribe_block_stream(block_stream_handler handler)
+{
+    block_stream_subscriber_->subscribe(handler, error::channel_stopped, {},
+        0, {});
+}
+
 // Read cycle (read continues until stop).
 // ----------------------------------------------------------------------------
 
@@ -174,9 +265,30 @@ void proxy::handle_read_heading(const boost_code& ec, size_t)
         return;
     }
 
+    // The checksum and payload retention require the full payload, so they
+    // preclude streaming.
+    if (stream_blocks_ && head.type() == message_type::block &&
+        !pass_through(head.command()))
+    {
+        const auto parser = std::make_shared<block_parser>(head.payload_size(),
+            std::bind(&proxy::handle_block_transaction,
+                shared_from_this(), _1, _2, _3));
+
+        read_block(head, parser);
+        return;
+    }
+
     read_payload(head);
 }
 
+// Retained payloads are copied from the read buffer and hashed once, which
+// verifies the checksum and provides the hash of the payload for reuse.
+bool proxy::retained(const heading& head) const
+{
+    return retain_payloads_ && (head.type() == message_type::transaction ||
+        head.type() == message_type::block);
+}
+
 void proxy::read_payload(const heading& head)
 {
     if (stopped())
@@ -205,9 +317,24 @@ void proxy::handle_read_payload(const boost_code& ec, size_t payload_size,
         return;
     }
 
+    if (pass_through(head.command()))
+    {
+        handle_pass_through(head);
+        return;
+    }
+
+    wire_payload payload;
+
+    if (retained(head))
+    {
+        payload.data = std::make_shared<const data_chunk>(payload_buffer_);
+        payload.hash = bitcoin_hash(*payload.data);
+    }
+
     // This is a pointless test but we allow it as an option for completeness.
-    if (validate_checksum_ &&
-        head.checksum() != bitcoin_checksum(payload_buffer_))
+    if ((payload.data && head.checksum() != payload.checksum()) ||
+        (!payload.data && validate_checksum_ &&
+        head.checksum() != bitcoin_checksum(payload_buffer_)))
     {
         LOG_WARNING(LOG_NETWORK)
             << "Invalid " << head.command() << " payload from [" << authority()
@@ -221,7 +348,8 @@ void proxy::handle_read_payload(const boost_code& ec, size_t payload_size,
     payload_stream istream(source);
 
     // Failures are not forwarded to subscribers and channel is stopped below.
-    const auto code = message_subscriber_.load(head.type(), version_, istream);
+    const auto code = message_subscriber_.load(head.type(), version_, istream,
+        payload, track_delivery(payload_size));
     const auto consumed = istream.peek() == std::istream::traits_type::eof();
 
     if (verbose_ && code)
@@ -259,39 +387,484 @@ void proxy::handle_read_payload(const boost_code& ec, size_t payload_size,
         << "] (" << payload_size << " bytes)";
 
     signal_activity();
+
+    if (throttled())
+        return;
+
     read_heading();
 }
 
-// Message send sequence.
+// Block streaming read cycle.
+// ----------------------------------------------------------------------------
+
+void proxy::read_block(const heading& head, block_parser::ptr parser)
+{
+    if (stopped())
+        return;
+
+    // This does not cause a reallocation.
+    payload_buffer_.resize(std::min(parser->remaining(), block_chunk_size));
+
+    async_read(socket_->get(), buffer(payload_buffer_),
+        std::bind(&proxy::handle_read_block,
+            shared_from_this(), _1, _2, head, parser));
+}
+
+void proxy::handle_read_block(const boost_code& ec, size_t,
+    const heading& head, block_parser::ptr parser)
+{
+    if (stopped())
+        return;
+
+    if (ec)
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Payload read failure [" << authority() << "] "
+            << code(error::boost_to_error_code(ec)).message();
+        stop(ec);
+        return;
+    }
+
+    // Complete transactions are parsed and streamed as each piece arrives.
+    const auto code = parser->write(payload_buffer_);
+
+    if (code)
+    {
+        LOG_WARNING(LOG_NETWORK)
+            << "Invalid " << head.command() << " payload from [" << authority()
+            << "] " << code.message();
+        stop(code);
+        return;
+    }
+
+    // Keep the channel alive while a large block trickles in.
+    signal_activity();
+
+    if (!parser->complete())
+    {
+        read_block(head, parser);
+        return;
+    }
+
+    message_subscriber_.load(parser->finish(),
+        track_delivery(head.payload_size()));
+
+    LOG_VERBOSE(LOG_NETWORK)
+        << "Received " << head.command() << " from [" << authority()
+        << "] (" << head.payload_size() << " bytes)";
+
+    if (throttled())
+        return;
+
+    read_heading();
+}
+
+// The payload is copied from the read buffer but not parsed.
+void proxy::handle_pass_through(const heading& head)
+{
+    const auto payload = std::make_shared<const data_chunk>(payload_buffer_);
+
+    if (validate_checksum_ && head.checksum() != bitcoin_checksum(*payload))
+    {
+        LOG_WARNING(LOG_NETWORK)
+            << "Invalid " << head.command() << " payload from [" << authority()
+            << "] bad checksum.";
+        stop(error::bad_stream);
+        return;
+    }
+
+    raw_subscriber_->invoke(error::success, head, payload);
+
+    LOG_VERBOSE(LOG_NETWORK)
+        << "Passed " << head.command() << " from [" << authority()
+        << "] (" << payload->size() << " bytes)";
+
+    signal_activity();
+    read_heading();
+}
+
+void proxy::deliver(block_const_ptr block)
+{
+    if (stopped())
+        return;
+
+    message_subscriber_.load(block, []() {});
+}
+
+void proxy::handle_block_transaction(header_const_ptr header, size_t index,
+    transaction_const_ptr transaction)
+{
+    // Invoke preserves transaction order and blocks the peer while handling.
+    block_stream_subscriber_->invoke(error::success, header, index,
+        transaction);
+}
+
+// Read backpressure.
+// ----------------------------------------------------------------------------
+// Reading pauses while payloads not yet delivered to all subscribers exceed
+// the limit, and resumes once delivery drains them to half of the limit.
+// This leaves the peer to be throttled by TCP flow control.
+
+// Account for the payload until it has been delivered to all subscribers.
+message_subscriber::completion_handler proxy::track_delivery(size_t size)
+{
+    if (backlog_limit_ == 0)
+        return []() {};
+
+    backlog_ += size;
+    return std::bind(&proxy::handle_delivered, shared_from_this(), size);
+}
+
+bool proxy::throttled()
+{
+    if (backlog_limit_ == 0 || backlog_ <= backlog_limit_)
+        return false;
+
+    LOG_VERBOSE(LOG_NETWORK)
+        << "Pausing read from [" << authority() << "] (" << backlog_
+        << " bytes undelivered)";
+
+    paused_ = true;
+
+    // Delivery may have drained the backlog before the pause was visible, in
+    // which case the read cycle continues here unless delivery resumed it.
+    return backlog_ > backlog_limit_ / 2 || !paused_.exchange(false);
+}
+
+void proxy::handle_delivered(size_t size)
+{
+    const auto backlog = (backlog_ -= size);
+
+    if (backlog > backlog_limit_ / 2 || !paused_.exchange(false))
+        return;
+
+    LOG_VERBOSE(LOG_NETWORK)
+        << "Resuming read from [" << authority() << "]";
+
+    read_heading();
+}
+
+// Send queue.
 // ----------------------------------------------------------------------------
+// Only one write is outstanding at a time, because a write may occur in
+// multiple asynchronous steps invoked on different threads. The next message
+// is selected at each message boundary, by priority and then in order of
+// submission, so a control message never waits for more than the one write
+// in progress. If prioritization is disabled messages are sent in order.
+// A shaped message is held outside of the queue while it awaits tokens, and
+// control messages are written ahead of it in the meantime.
+
+send_priority proxy::classify(const std::string& command)
+{
+    if (command == message::ping::command ||
+        command == message::pong::command ||
+        command == message::verack::command ||
+        command == message::version::command ||
+        command == message::reject::command ||
+        command == message::send_headers::command ||
+        command == message::send_compact::command ||
+        command == message::fee_filter::command ||
+        command == message::filter_add::command ||
+        command == message::filter_clear::command ||
+        command == message::filter_load::command)
+        return send_priority::control;
+
+    if (command == message::block::command ||
+        command == message::transaction::command ||
+        command == message::headers::command ||
+        command == message::merkle_block::command ||
+        command == message::compact_block::command ||
+        command == message::block_transactions::command)
+        return send_priority::bulk;
+
+    return send_priority::announcement;
+}
+
+size_t proxy::send_queue_depth(send_priority priority) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(send_mutex_);
+
+    return send_queues_[static_cast<size_t>(priority)].size();
+    ///////////////////////////////////////////////////////////////////////////
+}
 
-void proxy::do_send(command_ptr command, payload_ptr payload,
+size_t proxy::send_queue_bytes(send_priority priority) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(send_mutex_);
+
+    return send_bytes_[static_cast<size_t>(priority)];
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void proxy::send_raw(const std::string& command, data_ptr message,
     result_handler handler)
 {
-    async_write(socket_->get(), buffer(*payload),
+    enqueue(classify(command), std::make_shared<std::string>(command), {},
+        message, handler);
+}
+
+void proxy::send_raw(const std::string& command, data_ptr payload,
+    uint32_t checksum, result_handler handler)
+{
+    const heading head(protocol_magic_, command,
+        static_cast<uint32_t>(payload->size()), checksum);
+    const auto framing = std::make_shared<const data_chunk>(head.to_data());
+    enqueue(classify(command), std::make_shared<std::string>(command),
+        framing, payload, handler);
+}
+
+void proxy::enqueue(send_priority priority, command_ptr command,
+    payload_ptr heading, payload_ptr payload, result_handler handler)
+{
+    if (stopped())
+    {
+        handler(error::channel_stopped);
+        return;
+    }
+
+    const auto index = static_cast<size_t>(priority);
+    outbound next;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    send_mutex_.lock();
+
+    const outbound message{ priority, sequence_++, command, heading, payload,
+        handler };
+    send_queues_[index].push_back(message);
+    send_bytes_[index] += message.size();
+
+    if (sending_)
+    {
+        send_mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    auto shape = false;
+    const auto more = dequeue(next, shape);
+    sending_ = more && !shape;
+
+    send_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (more)
+        do_send(next, shape);
+}
+
+// Must be called under send_mutex_, with no write in progress. Sets shape if
+// the message must await the shaper before it is written. While a message
+// awaits the shaper only control messages are selected, and only if sends
+// are prioritized. A granted message is selected ahead of all others.
+bool proxy::dequeue(outbound& out, bool& shape)
+{
+    if (granted_)
+    {
+        out = held_;
+        held_ = {};
+        granted_ = false;
+        shaping_ = false;
+        shape = false;
+        return true;
+    }
+
+    auto selected = send_queues_.end();
+
+    for (auto queue = send_queues_.begin(); queue != send_queues_.end();
+        ++queue)
+    {
+        if (queue->empty())
+            continue;
+
+        if (selected == send_queues_.end() ||
+            queue->front().sequence < selected->front().sequence)
+            selected = queue;
+
+        if (prioritize_sends_)
+            break;
+    }
+
+    if (selected == send_queues_.end())
+        return false;
+
+    const auto control = selected->front().priority == send_priority::control;
+
+    if (shaping_ && !(control && prioritize_sends_))
+        return false;
+
+    const auto index = std::distance(send_queues_.begin(), selected);
+    out = selected->front();
+    selected->pop_front();
+    send_bytes_[index] -= out.size();
+
+    shape = shaper_ && !control;
+    shaping_ = shaping_ || shape;
+    return true;
+}
+
+void proxy::clear_queue(const code& ec)
+{
+    std::vector<outbound> cleared;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    send_mutex_.lock();
+
+    for (size_t index = 0; index < priorities; ++index)
+    {
+        auto& queue = send_queues_[index];
+        cleared.insert(cleared.end(), queue.begin(), queue.end());
+        queue.clear();
+        send_bytes_[index] = 0;
+    }
+
+    if (granted_)
+        cleared.push_back(held_);
+
+    held_ = {};
+    granted_ = false;
+    shaping_ = false;
+    sending_ = false;
+
+    send_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& message: cleared)
+        message.handler(ec);
+}
+
+// Message send sequence.
+// ----------------------------------------------------------------------------
+
+// Control messages are charged to the shaper but never delayed by it.
+void proxy::do_send(outbound message, bool shape)
+{
+    if (!shaper_)
+    {
+        do_write(error::success, message);
+        return;
+    }
+
+    if (!shape)
+    {
+        shaper_->request(flow_, message.size(), true,
+            std::bind(&proxy::do_write,
+                shared_from_this(), _1, message));
+        return;
+    }
+
+    shaper_->request(flow_, message.size(), false,
+        std::bind(&proxy::handle_granted,
+            shared_from_this(), _1, message));
+}
+
+// The granted message is written now, or after the write in progress.
+void proxy::handle_granted(const code& ec, outbound message)
+{
+    if (ec)
+    {
+        do_write(ec, message);
+        return;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    send_mutex_.lock();
+
+    if (sending_)
+    {
+        held_ = message;
+        granted_ = true;
+        send_mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    sending_ = true;
+    shaping_ = false;
+
+    send_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    do_write(error::success, message);
+}
+
+void proxy::do_write(const code& ec, outbound message)
+{
+    if (ec)
+    {
+        clear_queue(ec);
+        message.handler(ec);
+        return;
+    }
+
+    // The buffers are retained by the message, which is bound to the handler.
+    if (message.heading)
+    {
+        const std::array<const_buffer, 2> buffers
+        {
+            {
+                buffer(*message.heading),
+                buffer(*message.payload)
+            }
+        };
+
+        async_write(socket_->get(), buffers,
+            std::bind(&proxy::handle_send,
+                shared_from_this(), _1, _2, message));
+        return;
+    }
+
+    async_write(socket_->get(), buffer(*message.payload),
         std::bind(&proxy::handle_send,
-            shared_from_this(), _1, _2, command, payload, handler));
+            shared_from_this(), _1, _2, message));
 }
 
-void proxy::handle_send(const boost_code& ec, size_t, command_ptr command,
-    payload_ptr payload, result_handler handler)
+void proxy::handle_send(const boost_code& ec, size_t, outbound message)
 {
-    dispatch_.unlock();
-    const auto size = payload->size();
+    const auto& command = message.command;
+    const auto& handler = message.handler;
+    const auto size = message.size();
     const auto error = code(error::boost_to_error_code(ec));
 
     if (stopped())
     {
+        clear_queue(error::channel_stopped);
         handler(error);
         return;
     }
 
+    if (!error)
+    {
+        outbound next;
+        auto shape = false;
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        send_mutex_.lock();
+
+        const auto more = dequeue(next, shape);
+        sending_ = more && !shape;
+
+        send_mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        // Start the next write before handling completion of this one.
+        if (more)
+            do_send(next, shape);
+    }
+
     if (error)
     {
         LOG_DEBUG(LOG_NETWORK)
             << "Failure sending " << *command << " to [" << authority()
             << "] (" << size << " bytes) " << error.message();
         stop(error);
+        clear_queue(error::channel_stopped);
         handler(error);
         return;
     }
@@ -320,10 +893,22 @@ void proxy::stop(const code& ec)
     message_subscriber_.stop();
     message_subscriber_.broadcast(error::channel_stopped);
 
+    // Prevent subscription after stop.
+    block_stream_subscriber_->stop();
+    block_stream_subscriber_->relay(error::channel_stopped, {}, 0, {});
+
+    // Prevent subscription after stop.
+    raw_subscriber_->stop();
+    raw_subscriber_->relay(error::channel_stopped, {}, {});
+
     // Prevent subscription after stop.
     stop_subscriber_->stop();
     stop_subscriber_->relay(ec);
 
+    // Release the upload flow, failing any write awaiting its turn.
+    if (shaper_)
+        shaper_->close(flow_);
+
     // Give channel opportunity to terminate timers.
     handle_stopping();
 
@@ -336,6 +921,10 @@ void proxy::stop(const boost_code& ec)
     stop(error::boost_to_error_code(ec));
 }
 
+void proxy::sending(const message::headers&)
+{
+}
+
 bool proxy::stopped() const
 {
     return stopped_;
@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/reconciliation_set.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/pin_sketch.hpp>
+#include <bitcoin/network/sip_hash.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+const size_t reconciliation_set::maximum_size = 3000;
+
+static const std::string salt_tag = "Tx Relay Salting";
+
+// The salt is the tagged hash of the ordered salts of the peers (bip330).
+static hash_digest combine(uint64_t local_salt, uint64_t remote_salt)
+{
+    const auto tag = sha256_hash(to_chunk(salt_tag));
+
+    return sha256_hash(build_chunk(
+    {
+        tag,
+        tag,
+        to_little_endian(std::min(local_salt, remote_salt)),
+        to_little_endian(std::max(local_salt, remote_salt))
+    }));
+}
+
+static uint64_t threshold(double rate)
+{
+    if (rate <= 0.0)
+        return 0;
+
+    if (rate >= 1.0)
+        return max_uint64;
+
+    return static_cast<uint64_t>(rate * static_cast<double>(max_uint64));
+}
+
+reconciliation_set::reconciliation_set(uint64_t local_salt,
+    uint64_t remote_salt, double flood_rate)
+  : salt_(combine(local_salt, remote_salt)),
+    key0_(from_little_endian_unsafe<uint64_t>(salt_.begin())),
+    key1_(from_little_endian_unsafe<uint64_t>(salt_.begin() +
+        sizeof(uint64_t))),
+    flood_threshold_(threshold(flood_rate))
+{
+}
+
+// Zero is not a sketch element, so short ids are offset by one.
+uint32_t reconciliation_set::short_id(const hash_digest& hash) const
+{
+    return static_cast<uint32_t>(1 + sip_hash(key0_, key1_, hash) %
+        max_uint32);
+}
+
+// The reversed keys give a selection independent of the short id.
+bool reconciliation_set::flood(const hash_digest& hash) const
+{
+    return flood_threshold_ == max_uint64 ||
+        sip_hash(key1_, key0_, hash) < flood_threshold_;
+}
+
+bool reconciliation_set::insert(const hash_digest& hash)
+{
+    const auto id = short_id(hash);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (set_.size() >= maximum_size)
+        return false;
+
+    set_.emplace(id, hash);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t reconciliation_set::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return set_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Reconciliation.
+// ----------------------------------------------------------------------------
+
+size_t reconciliation_set::snapshot()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    snapshot_.insert(set_.begin(), set_.end());
+    set_.clear();
+    return snapshot_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+pin_sketch reconciliation_set::sketch(size_t capacity) const
+{
+    pin_sketch out(capacity);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    for (const auto& entry: snapshot_)
+        out.add(entry.first);
+    ///////////////////////////////////////////////////////////////////////////
+
+    return out;
+}
+
+hash_list reconciliation_set::complete(const short_ids& ids,
+    short_ids& out_missing)
+{
+    hash_list out;
+    out_missing.clear();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    for (const auto id: ids)
+    {
+        const auto it = snapshot_.find(id);
+
+        if (it == snapshot_.end())
+            out_missing.push_back(id);
+        else
+            out.push_back(it->second);
+    }
+
+    snapshot_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return out;
+}
+
+hash_list reconciliation_set::complete()
+{
+    hash_list out;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    out.reserve(snapshot_.size());
+
+    for (const auto& entry: snapshot_)
+        out.push_back(entry.second);
+
+    snapshot_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return out;
+}
+
+} // namespace network
+} // namespace libbitcoin
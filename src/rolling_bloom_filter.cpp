@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/rolling_bloom_filter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+static const size_t word_bits = 64;
+
+// Each generation is checked, so each takes half of the false positive rate.
+static size_t bits_for(size_t elements, double false_positive_rate)
+{
+    const auto ln2 = std::log(2.0);
+    const auto rate = std::max(false_positive_rate / 2, 1e-12);
+    const auto bits = -std::log(rate) * elements / (ln2 * ln2);
+    return std::max<size_t>(word_bits, static_cast<size_t>(std::ceil(bits)));
+}
+
+static size_t functions_for(size_t elements, size_t bits)
+{
+    const auto count = std::log(2.0) * bits / std::max<size_t>(elements, 1);
+    return std::min<size_t>(50, std::max<size_t>(1, std::lround(count)));
+}
+
+// Finalizer of splitmix64, to spread the tweaked hash words.
+static uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+    return value ^ (value >> 31);
+}
+
+rolling_bloom_filter::rolling_bloom_filter(size_t elements,
+    double false_positive_rate)
+  : elements_(std::max<size_t>(elements, 1)),
+    functions_(functions_for(elements_, bits_for(elements_,
+        false_positive_rate))),
+    size_(bits_for(elements_, false_positive_rate)),
+    tweak_(pseudo_random(0, max_uint64)),
+    count_(0),
+    current_((size_ + word_bits - 1) / word_bits, 0),
+    previous_((size_ + word_bits - 1) / word_bits, 0)
+{
+}
+
+// Double hashing over two independent words of the (uniform) hash.
+size_t rolling_bloom_filter::position(const hash_digest& hash,
+    size_t function) const
+{
+    const auto first = from_little_endian_unsafe<uint64_t>(hash.begin());
+    const auto second = from_little_endian_unsafe<uint64_t>(hash.begin() + 8);
+    const auto value = mix(first ^ tweak_) + function * mix(second + tweak_);
+    return static_cast<size_t>(value % size_);
+}
+
+void rolling_bloom_filter::insert(const hash_digest& hash)
+{
+    if (count_ == elements_)
+    {
+        previous_.swap(current_);
+        std::fill(current_.begin(), current_.end(), 0);
+        count_ = 0;
+    }
+
+    for (size_t function = 0; function < functions_; ++function)
+    {
+        const auto bit = position(hash, function);
+        current_[bit / word_bits] |= uint64_t(1) << (bit % word_bits);
+    }
+
+    ++count_;
+}
+
+bool rolling_bloom_filter::contains(const hash_digest& hash) const
+{
+    return contains(current_, hash) || contains(previous_, hash);
+}
+
+bool rolling_bloom_filter::contains(const bits& generation,
+    const hash_digest& hash) const
+{
+    for (size_t function = 0; function < functions_; ++function)
+    {
+        const auto bit = position(hash, function);
+        if ((generation[bit / word_bits] & (uint64_t(1) << (bit % word_bits)))
+            == 0)
+            return false;
+    }
+
+    return true;
+}
+
+void rolling_bloom_filter::clear()
+{
+    std::fill(current_.begin(), current_.end(), 0);
+    std::fill(previous_.begin(), previous_.end(), 0);
+    count_ = 0;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -29,6 +29,18 @@
 #include <bitcoin/network/connector.hpp>
 #include <bitcoin/network/p2p.hpp>
 #include <bitcoin/network/proxy.hpp>
+#include <bitcoin/network/protocols/protocol_address_31402.hpp>
+#include <bitcoin/network/protocols/protocol_block_download_31402.hpp>
+#include <bitcoin/network/protocols/protocol_bloom_filter_70001.hpp>
+#include <bitcoin/network/protocols/protocol_compact_block_70014.hpp>
+#include <bitcoin/network/protocols/protocol_fee_filter_70013.hpp>
+#include <bitcoin/network/protocols/protocol_inventory_31402.hpp>
+#include <bitcoin/network/protocols/protocol_ping_31402.hpp>
+#include <bitcoin/network/protocols/protocol_ping_60001.hpp>
+#include <bitcoin/network/protocols/protocol_reconciliation_70014.hpp>
+#include <bitcoin/network/protocols/protocol_reject_70002.hpp>
+#include <bitcoin/network/protocols/protocol_send_headers_70012.hpp>
+#include <bitcoin/network/protocols/protocol_transaction_download_31402.hpp>
 #include <bitcoin/network/protocols/protocol_version_31402.hpp>
 #include <bitcoin/network/protocols/protocol_version_70002.hpp>
 #include <bitcoin/network/settings.hpp>
@@ -41,6 +53,17 @@ namespace network {
 
 using namespace std::placeholders;
 
+// Message types moved to the dedicated threadpool, if there is one.
+static const message::message_type bulk_message_types[] =
+{
+    message::message_type::block,
+    message::message_type::block_transactions,
+    message::message_type::compact_block,
+    message::message_type::headers,
+    message::message_type::merkle_block,
+    message::message_type::transaction
+};
+
 session::session(p2p& network, bool notify_on_connect)
   : pool_(network.thread_pool()),
     settings_(network.network_settings()),
@@ -75,6 +98,16 @@ code session::fetch_address(address& out_address) const
     return network_.fetch_address(out_address);
 }
 
+code session::fetch_anchor(address& out_address)
+{
+    return network_.fetch_anchor(out_address);
+}
+
+void session::store(const address::list& addresses, result_handler handler)
+{
+    network_.store(addresses, handler);
+}
+
 bool session::blacklisted(const authority& authority) const
 {
     const auto ip_compare = [&](const config::authority& blocked)
@@ -106,7 +139,13 @@ acceptor::ptr session::create_acceptor()
 
 connector::ptr session::create_connector()
 {
-    return std::make_shared<connector>(pool_, settings_);
+    return std::make_shared<connector>(pool_, settings_,
+        network_.connect_attempts());
+}
+
+connect_scheduler::ptr session::connect_attempts() const
+{
+    return network_.connect_attempts();
 }
 
 // Pending connect.
@@ -197,12 +236,36 @@ void session::start_channel(channel::ptr channel,
 {
     channel->set_notify(notify_on_connect_);
     channel->set_nonce(pseudo_random(1, max_uint64));
+    set_delivery_policy(channel);
+
+    // Unshaped channels write without a shaper request per message.
+    if (settings_.upload_kilobytes_per_second != 0 ||
+        settings_.peer_upload_kilobytes_per_second != 0)
+        channel->set_upload_shaper(network_.shaper());
 
     // The channel starts, invokes the handler, then starts the read cycle.
     channel->start(
         BIND3(handle_starting, _1, channel, handle_started));
 }
 
+// Control messages are small and latency sensitive, so they are handled on
+// the read thread. Unless there are no dedicated threads, bulk data handlers
+// are moved to the dedicated pool so that they do not delay the read cycle.
+void session::set_delivery_policy(channel::ptr channel)
+{
+    using namespace message;
+
+    channel->set_delivery_policy(message_type::reject, delivery::handle);
+
+    if (settings_.dedicated_threads == 0)
+        return;
+
+    channel->set_dedicated_pool(network_.dedicated_pool());
+
+    for (const auto type: bulk_message_types)
+        channel->set_delivery_policy(type, delivery::dedicated);
+}
+
 void session::handle_starting(const code& ec, channel::ptr channel,
     result_handler handle_started)
 {
@@ -281,5 +344,59 @@ void session::handle_remove(const code& ec, channel::ptr channel,
     handle_stopped(error::success);
 }
 
+// Protocol attachment.
+// ----------------------------------------------------------------------------
+
+void session::attach_ping_protocols(channel::ptr channel)
+{
+    if (channel->negotiated_version() >= message::version::level::bip31)
+        attach<protocol_ping_60001>(channel)->start();
+    else
+        attach<protocol_ping_31402>(channel)->start();
+}
+
+// The inventory protocol is attached to all relay channels for block
+// announcements (to and from peers without headers announcement), but
+// announces transactions only with full relay.
+void session::attach_relay_protocols(channel::ptr channel, bool full_relay,
+    bool initiate_reconciliation, bool download_blocks, bool high_bandwidth)
+{
+    using level = message::version::level;
+    using serve = message::version::service;
+    const auto version = channel->negotiated_version();
+
+    if (version >= level::bip61)
+        attach<protocol_reject_70002>(channel)->start();
+
+    if (full_relay)
+        attach<protocol_address_31402>(channel)->start();
+
+    attach<protocol_inventory_31402>(channel, full_relay)->start();
+
+    if (settings_.send_headers && version >= level::bip130)
+        attach<protocol_send_headers_70012>(channel)->start();
+
+    if (full_relay && version >= level::bip133)
+        attach<protocol_fee_filter_70013>(channel)->start();
+
+    if (full_relay && version >= level::bip37 &&
+        (settings_.services & serve::node_bloom) != 0)
+        attach<protocol_bloom_filter_70001>(channel)->start();
+
+    if (full_relay && settings_.reconcile_transactions &&
+        version >= level::bip152)
+        attach<protocol_reconciliation_70014>(channel,
+            initiate_reconciliation)->start();
+
+    if (full_relay && settings_.schedule_transactions)
+        attach<protocol_transaction_download_31402>(channel)->start();
+
+    if (download_blocks && settings_.schedule_blocks)
+        attach<protocol_block_download_31402>(channel)->start();
+
+    if (settings_.compact_blocks && version >= level::bip152)
+        attach<protocol_compact_block_70014>(channel, high_bandwidth)->start();
+}
+
 } // namespace network
 } // namespace libbitcoin
@@ -40,11 +40,48 @@ session_batch::session_batch(p2p& network, bool notify_on_connect)
 {
 }
 
+// protected:
+bool session_batch::anchored() const
+{
+    return true;
+}
+
 // Connect sequence.
 // ----------------------------------------------------------------------------
 
 // protected:
+// Anchors are dialed singly, since a batch uses only its first connection.
 void session_batch::connect(channel_handler handler)
+{
+    network_address anchor;
+
+    if (!anchored() || fetch_anchor(anchor))
+    {
+        connect_batch(handler);
+        return;
+    }
+
+    LOG_DEBUG(LOG_NETWORK)
+        << "Connecting to anchor [" << authority(anchor) << "]";
+
+    start_connect(error::success, anchor,
+        BIND3(handle_anchor, _1, _2, handler));
+}
+
+// A failed anchor is followed immediately by the next anchor (or a batch).
+void session_batch::handle_anchor(const code& ec, channel::ptr channel,
+    channel_handler handler)
+{
+    if (!ec || stopped(ec))
+    {
+        handler(ec, channel);
+        return;
+    }
+
+    connect(handler);
+}
+
+void session_batch::connect_batch(channel_handler handler)
 {
     const auto join_handler = synchronize(handler, batch_size_, NAME "_join",
         synchronizer_terminate::on_success);
@@ -97,6 +134,15 @@ void session_batch::start_connect(const code& ec, const authority& host,
         return;
     }
 
+    // A host that recently failed is skipped until its backoff elapses.
+    if (connect_attempts()->delay(endpoint(host)) != asio::duration::zero())
+    {
+        LOG_VERBOSE(LOG_NETWORK)
+            << "Deferred address [" << host << "] after recent failure";
+        handler(error::address_blocked, nullptr);
+        return;
+    }
+
     LOG_VERBOSE(LOG_NETWORK)
         << "Connecting to [" << host << "]";
 
@@ -105,20 +151,26 @@ void session_batch::start_connect(const code& ec, const authority& host,
 
     // CONNECT
     connector->connect(host,
-        BIND4(handle_connect, _1, _2, connector, handler));
+        BIND5(handle_connect, _1, _2, host, connector, handler));
 }
 
 void session_batch::handle_connect(const code& ec, channel::ptr channel,
-    connector::ptr connector, channel_handler handler)
+    const authority& host, connector::ptr connector,
+    channel_handler handler)
 {
     unpend(connector);
 
     if (ec)
     {
+        if (!stopped(ec))
+            connect_attempts()->failed(endpoint(host));
+
         handler(ec, nullptr);
         return;
     }
 
+    connect_attempts()->succeeded(endpoint(host));
+
     LOG_DEBUG(LOG_NETWORK)
         << "Connected to [" << channel->authority() << "]";
 
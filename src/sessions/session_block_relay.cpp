@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/sessions/session_block_relay.hpp>
+
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/p2p.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+#define CLASS session_block_relay
+
+session_block_relay::session_block_relay(p2p& network, bool notify_on_connect)
+  : session_outbound(network, notify_on_connect),
+    CONSTRUCT_TRACK(session_block_relay)
+{
+}
+
+// Address, fee filter, bloom filter, reconciliation and transaction download
+// protocols are not attached.
+void session_block_relay::attach_protocols(channel::ptr channel)
+{
+    attach_relay_protocols(channel, false, false, true,
+        settings_.compact_blocks_high_bandwidth);
+}
+
+size_t session_block_relay::connection_target() const
+{
+    return settings_.block_relay_connections;
+}
+
+size_t session_block_relay::standby_target() const
+{
+    return 0;
+}
+
+bool session_block_relay::relay_transactions() const
+{
+    return false;
+}
+
+bool session_block_relay::anchored() const
+{
+    return false;
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -22,10 +22,6 @@
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/p2p.hpp>
-#include <bitcoin/network/protocols/protocol_address_31402.hpp>
-#include <bitcoin/network/protocols/protocol_ping_31402.hpp>
-#include <bitcoin/network/protocols/protocol_ping_60001.hpp>
-#include <bitcoin/network/protocols/protocol_reject_70002.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -37,7 +33,8 @@ using namespace std::placeholders;
 session_inbound::session_inbound(p2p& network, bool notify_on_connect)
   : session(network, notify_on_connect),
     connection_limit_(settings_.inbound_connections +
-        settings_.outbound_connections + settings_.peers.size()),
+        settings_.outbound_connections + settings_.block_relay_connections +
+        settings_.standby_connections + settings_.peers.size()),
     CONSTRUCT_TRACK(session_inbound)
 {
 }
@@ -177,17 +174,8 @@ void session_inbound::handle_channel_start(const code& ec,
 
 void session_inbound::attach_protocols(channel::ptr channel)
 {
-    const auto version = channel->negotiated_version();
-
-    if (version >= message::version::level::bip31)
-        attach<protocol_ping_60001>(channel)->start();
-    else
-        attach<protocol_ping_31402>(channel)->start();
-
-    if (version >= message::version::level::bip61)
-        attach<protocol_reject_70002>(channel)->start();
-
-    attach<protocol_address_31402>(channel)->start();
+    attach_ping_protocols(channel);
+    attach_relay_protocols(channel, true, false, false, false);
 }
 
 void session_inbound::handle_channel_stop(const code& ec)
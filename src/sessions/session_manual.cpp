@@ -18,16 +18,13 @@
  */
 #include <bitcoin/network/sessions/session_manual.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <string>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/p2p.hpp>
-#include <bitcoin/network/protocols/protocol_address_31402.hpp>
-#include <bitcoin/network/protocols/protocol_ping_31402.hpp>
-#include <bitcoin/network/protocols/protocol_ping_60001.hpp>
-#include <bitcoin/network/protocols/protocol_reject_70002.hpp>
 
 namespace libbitcoin {
 namespace network {
@@ -111,20 +108,27 @@ void session_manual::handle_connect(const code& ec, channel::ptr channel,
     connector::ptr connector, channel_handler handler)
 {
     unpend(connector);
+    const config::endpoint host(hostname, port);
 
     if (ec)
     {
         LOG_WARNING(LOG_NETWORK)
-            << "Failure connecting [" << config::endpoint(hostname, port)
-            << "] manually: " << ec.message();
+            << "Failure connecting [" << host << "] manually: "
+            << ec.message();
+
+        if (!stopped(ec))
+            connect_attempts()->failed(host);
 
         // Retry forever if limit is zero.
         remaining = settings_.manual_attempt_limit == 0 ? 1 : remaining;
 
         if (remaining > 0)
         {
-            // Retry with conditional delay, regardless of error.
-            dispatch_delayed(cycle_delay(ec),
+            // Retry with the greater of conditional and backoff delay.
+            const auto delay = std::max(cycle_delay(ec),
+                connect_attempts()->delay(host));
+
+            dispatch_delayed(delay,
                 BIND5(start_connect, _1, hostname, port, remaining, handler));
             return;
         }
@@ -139,6 +143,8 @@ void session_manual::handle_connect(const code& ec, channel::ptr channel,
         return;
     }
 
+    connect_attempts()->succeeded(host);
+
     register_channel(channel,
         BIND5(handle_channel_start, _1, hostname, port, channel, handler),
         BIND3(handle_channel_stop, _1, hostname, port));
@@ -170,17 +176,8 @@ void session_manual::handle_channel_start(const code& ec,
 
 void session_manual::attach_protocols(channel::ptr channel)
 {
-    const auto version = channel->negotiated_version();
-
-    if (version >= message::version::level::bip31)
-        attach<protocol_ping_60001>(channel)->start();
-    else
-        attach<protocol_ping_31402>(channel)->start();
-
-    if (version >= message::version::level::bip61)
-        attach<protocol_reject_70002>(channel)->start();
-
-    attach<protocol_address_31402>(channel)->start();
+    attach_ping_protocols(channel);
+    attach_relay_protocols(channel, true, true, true, false);
 }
 
 void session_manual::handle_channel_stop(const code& ec,
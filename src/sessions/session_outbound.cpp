@@ -18,14 +18,11 @@
  */
 #include <bitcoin/network/sessions/session_outbound.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/network/p2p.hpp>
-#include <bitcoin/network/protocols/protocol_address_31402.hpp>
-#include <bitcoin/network/protocols/protocol_ping_31402.hpp>
-#include <bitcoin/network/protocols/protocol_ping_60001.hpp>
-#include <bitcoin/network/protocols/protocol_reject_70002.hpp>
 #include <bitcoin/network/protocols/protocol_version_31402.hpp>
 #include <bitcoin/network/protocols/protocol_version_70002.hpp>
 
@@ -47,7 +44,7 @@ session_outbound::session_outbound(p2p& network, bool notify_on_connect)
 
 void session_outbound::start(result_handler handler)
 {
-    if (settings_.outbound_connections == 0)
+    if (connection_target() == 0)
     {
         LOG_INFO(LOG_NETWORK)
             << "Not configured for generating outbound connections.";
@@ -69,7 +66,9 @@ void session_outbound::handle_started(const code& ec, result_handler handler)
         return;
     }
 
-    for (size_t peer = 0; peer < settings_.outbound_connections; ++peer)
+    const auto connections = connection_target() + standby_target();
+
+    for (size_t peer = 0; peer < connections; ++peer)
         new_connection(error::success);
 
     // This is the end of the start sequence.
@@ -98,8 +97,13 @@ void session_outbound::handle_connect(const code& ec, channel::ptr channel)
         LOG_DEBUG(LOG_NETWORK)
             << "Failure connecting outbound: " << ec.message();
 
+        // The hosts of a timed out batch are deferred, so the retry awaits
+        // the connect timeout rather than redialing the pool immediately.
+        const auto delay = ec == error::channel_timeout ?
+            connect_attempts()->timeout() : cycle_delay(ec);
+
         // Retry with conditional delay, regardless of error.
-        dispatch_delayed(cycle_delay(ec), BIND1(new_connection, _1));
+        dispatch_delayed(delay, BIND1(new_connection, _1));
         return;
     }
 
@@ -120,33 +124,56 @@ void session_outbound::handle_channel_start(const code& ec,
         return;
     }
 
+    attach_standby_protocols(channel);
+
+    if (!admit(channel))
+    {
+        LOG_INFO(LOG_NETWORK)
+            << "Connected standby channel [" << channel->authority() << "] ("
+            << connection_count() << ")";
+        return;
+    }
+
     LOG_INFO(LOG_NETWORK)
         << "Connected outbound channel [" << channel->authority() << "] ("
         << connection_count() << ")";
 
-    attach_protocols(channel);
+    activate(channel);
 };
 
-void session_outbound::attach_protocols(channel::ptr channel)
+// A spare runs only the standby protocols, so its (full relay) handshake
+// does not cause it to relay until activated.
+void session_outbound::activate(channel::ptr channel)
 {
-    const auto version = channel->negotiated_version();
+    // Outbound peers are candidates to be dialed first upon restart.
+    if (anchored())
+        channel->set_anchor(true);
 
-    if (version >= message::version::level::bip31)
-        attach<protocol_ping_60001>(channel)->start();
-    else
-        attach<protocol_ping_31402>(channel)->start();
+    // Replace the channel before it expires, if there is a standby channel.
+    if (standby_target() != 0)
+        channel->set_expiration_handler(
+            BIND2(handle_channel_expiration, _1, channel));
 
-    if (version >= message::version::level::bip61)
-        attach<protocol_reject_70002>(channel)->start();
+    attach_protocols(channel);
+}
 
-    attach<protocol_address_31402>(channel)->start();
+void session_outbound::attach_standby_protocols(channel::ptr channel)
+{
+    attach_ping_protocols(channel);
+}
+
+void session_outbound::attach_protocols(channel::ptr channel)
+{
+    attach_relay_protocols(channel, true, true, true,
+        settings_.compact_blocks_high_bandwidth);
 }
 
 void session_outbound::attach_handshake_protocols(channel::ptr channel,
     result_handler handle_started)
 {
     using serve = message::version::service;
-    const auto relay = settings_.relay_transactions;
+
+    const auto relay = relay_transactions();
     const auto own_version = settings_.protocol_maximum;
     const auto own_services = settings_.services;
     const auto invalid_services = settings_.invalid_services;
@@ -168,6 +195,21 @@ void session_outbound::attach_handshake_protocols(channel::ptr channel,
             ->start(handle_started);
 }
 
+size_t session_outbound::connection_target() const
+{
+    return settings_.outbound_connections;
+}
+
+size_t session_outbound::standby_target() const
+{
+    return settings_.standby_connections;
+}
+
+bool session_outbound::relay_transactions() const
+{
+    return settings_.relay_transactions;
+}
+
 void session_outbound::handle_channel_stop(const code& ec,
     channel::ptr channel)
 {
@@ -175,9 +217,81 @@ void session_outbound::handle_channel_stop(const code& ec,
         << "Outbound channel stopped [" << channel->authority() << "] "
         << ec.message();
 
+    const auto spare = promote(channel);
+
+    if (spare)
+    {
+        LOG_INFO(LOG_NETWORK)
+            << "Promoted standby channel [" << spare->authority()
+            << "] to replace [" << channel->authority() << "]";
+
+        activate(spare);
+    }
+
+    // Replenish the standby (or active) channels.
     new_connection(error::success);
 }
 
+// Make before break, the expiring channel stops after this returns.
+void session_outbound::handle_channel_expiration(const code&,
+    channel::ptr channel)
+{
+    const auto spare = promote(channel);
+
+    if (!spare)
+        return;
+
+    LOG_INFO(LOG_NETWORK)
+        << "Promoted standby channel [" << spare->authority()
+        << "] to replace expiring [" << channel->authority() << "]";
+
+    activate(spare);
+}
+
+// Standby.
+// ----------------------------------------------------------------------------
+
+bool session_outbound::admit(channel::ptr channel)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (active_.size() < connection_target())
+    {
+        active_.insert(channel);
+        return true;
+    }
+
+    standby_.push_back(channel);
+    return false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+channel::ptr session_outbound::promote(channel::ptr channel)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto it = std::find(standby_.begin(), standby_.end(), channel);
+
+    if (it != standby_.end())
+    {
+        standby_.erase(it);
+        return nullptr;
+    }
+
+    if (active_.erase(channel) == 0 || standby_.empty())
+        return nullptr;
+
+    const auto spare = standby_.front();
+    standby_.pop_front();
+    active_.insert(spare);
+    return spare;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 // Channel start sequence.
 // ----------------------------------------------------------------------------
 // Pend outgoing connections so we can detect connection to self.
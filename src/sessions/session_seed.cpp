@@ -18,6 +18,7 @@
  */
 #include <bitcoin/network/sessions/session_seed.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -39,6 +40,14 @@ namespace network {
 /// If seeding occurs it must generate an increase of 100 hosts or will fail.
 static const size_t minimum_host_increase = 100;
 
+/// Seed resolution suffices if it yields an address for each outbound
+/// connection, as dns seeds return far fewer records than seed peers.
+static size_t minimum_resolved_increase(const settings& settings)
+{
+    return std::max(settings.outbound_connections +
+        settings.block_relay_connections + settings.standby_connections, 1u);
+}
+
 using namespace std::placeholders;
 session_seed::session_seed(p2p& network)
   : session(network, false),
@@ -90,8 +99,11 @@ void session_seed::handle_started(const code& ec, result_handler handler)
     }
 
     // This is NOT technically the end of the start sequence, since the handler
-    // is not invoked until seeding operations are complete.
-    start_seeding(start_size, handler);
+    // is not invoked until seeding has sufficiently populated the pool.
+    if (settings_.dns_seeding)
+        start_resolving(start_size, handler);
+    else
+        start_seeding(start_size, handler);
 }
 
 void session_seed::attach_handshake_protocols(channel::ptr channel,
@@ -117,19 +129,119 @@ void session_seed::attach_handshake_protocols(channel::ptr channel,
             ->start(handle_started);
 }
 
+// DNS seed sequence.
+// ----------------------------------------------------------------------------
+// One resolution per seed replaces a connection, handshake and address
+// exchange, and yields many addresses rather than the sample of one peer.
+
+void session_seed::start_resolving(size_t start_size, result_handler handler)
+{
+    const auto complete = BIND3(handle_resolved, _1, start_size, handler);
+
+    const auto join_handler = synchronize(complete, settings_.seeds.size(),
+        NAME "_dns", synchronizer_terminate::on_count);
+
+    for (const auto& seed: settings_.seeds)
+        resolve_seed(seed, join_handler);
+}
+
+void session_seed::resolve_seed(const config::endpoint& seed,
+    result_handler handler)
+{
+    if (stopped())
+    {
+        LOG_DEBUG(LOG_NETWORK)
+            << "Suspended seed resolution";
+        handler(error::channel_stopped);
+        return;
+    }
+
+    LOG_INFO(LOG_NETWORK)
+        << "Resolving seed [" << seed << "]";
+
+    const auto connector = create_connector();
+    pend(connector);
+
+    connector->resolve(seed,
+        BIND5(handle_resolve, _1, _2, seed, connector, handler));
+}
+
+void session_seed::handle_resolve(const code& ec,
+    const message::network_address::list& addresses,
+    const config::endpoint& seed, connector::ptr connector,
+    result_handler handler)
+{
+    unpend(connector);
+
+    if (ec)
+    {
+        LOG_INFO(LOG_NETWORK)
+            << "Failure resolving seed [" << seed << "] " << ec.message();
+        handler(ec);
+        return;
+    }
+
+    store_resolved(addresses, seed, handler);
+}
+
+void session_seed::store_resolved(
+    const message::network_address::list& addresses,
+    const config::endpoint& seed, result_handler handler)
+{
+    address::list allowed;
+    allowed.reserve(addresses.size());
+
+    for (const auto& address: addresses)
+        if (!blacklisted(config::authority(address)))
+            allowed.push_back(address);
+
+    LOG_INFO(LOG_NETWORK)
+        << "Resolved seed [" << seed << "] (" << allowed.size() << " of "
+        << addresses.size() << ")";
+
+    store(allowed, handler);
+}
+
+// This ignores the error code because individual seed errors are suppressed.
+void session_seed::handle_resolved(const code&, size_t start_size,
+    result_handler handler)
+{
+    // We succeed if there is an address for each outbound connection.
+    const auto count = address_count();
+    const auto minimum = minimum_resolved_increase(settings_);
+
+    if (count >= ceiling_add(start_size, minimum))
+    {
+        // This is the end of the seed sequence.
+        handler(error::success);
+        return;
+    }
+
+    LOG_INFO(LOG_NETWORK)
+        << "Seed resolution yielded " << count - start_size
+        << " addresses, contacting seeds.";
+
+    start_seeding(start_size, handler);
+}
+
 // Seed sequence.
 // ----------------------------------------------------------------------------
 
+// The handler is invoked as soon as any seed brings the pool to the required
+// size, so that outbound connections need not await the slowest seed. The
+// remaining seeds continue to populate the pool in the background.
 void session_seed::start_seeding(size_t start_size, result_handler handler)
 {
-    const auto complete = BIND2(handle_complete, start_size, handler);
+    const auto complete = BIND2(handle_complete, _1, handler);
 
     const auto join_handler = synchronize(complete, settings_.seeds.size(),
-        NAME, synchronizer_terminate::on_count);
+        NAME, synchronizer_terminate::on_success);
+
+    const auto seeded = BIND3(handle_seeded, _1, start_size, join_handler);
 
     // We don't use parallel here because connect is itself asynchronous.
     for (const auto& seed: settings_.seeds)
-        start_seed(seed, join_handler);
+        start_seed(seed, seeded);
 }
 
 void session_seed::start_seed(const config::endpoint& seed,
@@ -219,16 +331,23 @@ void session_seed::handle_channel_stop(const code& ec)
         << "Seed channel stopped: " << ec.message();
 }
 
-// This accepts no error code because individual seed errors are suppressed.
-void session_seed::handle_complete(size_t start_size, result_handler handler)
+// This ignores the error code because individual seed errors are suppressed.
+void session_seed::handle_seeded(const code&, size_t start_size,
+    result_handler handler)
 {
     // We succeed only if there is a host count increase of at least 100.
     const auto increase = address_count() >=
         ceiling_add(start_size, minimum_host_increase);
 
-    // This is the end of the seed sequence.
     handler(increase ? error::success : error::peer_throttling);
 }
 
+// The synchronizer does not preserve the failure code of the last seed.
+void session_seed::handle_complete(const code& ec, result_handler handler)
+{
+    // This is the end of the seed sequence (upon first success or last seed).
+    handler(ec ? error::peer_throttling : error::success);
+}
+
 } // namespace network
 } // namespace libbitcoin
@@ -30,14 +30,38 @@ using namespace bc::message;
 // Common default values (no settings context).
 settings::settings()
   : threads(0),
+    dedicated_threads(0),
     protocol_maximum(version::level::maximum),
     protocol_minimum(version::level::minimum),
     services(version::service::none),
     invalid_services(160),
     relay_transactions(false),
+    schedule_transactions(false),
+    transaction_request_limit(100),
+    transaction_request_timeout_seconds(60),
+    schedule_blocks(false),
+    block_download_window(1024),
+    block_request_limit(16),
+    block_request_timeout_seconds(60),
+    block_stall_seconds(5),
+    send_headers(false),
+    compact_blocks(false),
+    compact_blocks_high_bandwidth(true),
+    bloom_filter_budget_milliseconds(50),
+    reconcile_transactions(false),
+    reconciliation_interval_seconds(8),
+    reconciliation_fanout(2),
     validate_checksum(false),
+    stream_blocks(false),
+    retain_payloads(false),
+    read_backlog_limit(0),
+    prioritize_sends(true),
+    upload_kilobytes_per_second(0),
+    peer_upload_kilobytes_per_second(0),
     inbound_connections(0),
     outbound_connections(8),
+    block_relay_connections(0),
+    standby_connections(0),
     manual_attempt_limit(0),
     connect_batch_size(5),
     connect_timeout_seconds(5),
@@ -46,8 +70,12 @@ settings::settings()
     channel_inactivity_minutes(10),
     channel_expiration_minutes(60),
     channel_germination_seconds(30),
+    channel_trickle_milliseconds(5000),
     host_pool_capacity(0),
+    dns_seeding(false),
     hosts_file("hosts.cache"),
+    anchor_connections(8),
+    anchors_file("anchors.cache"),
     self(unspecified_network_address),
 
     // [log]
@@ -120,7 +148,8 @@ settings::settings(config::settings context)
 
 size_t settings::minimum_connections() const
 {
-    return ceiling_add<size_t>(outbound_connections, peers.size());
+    return ceiling_add<size_t>(outbound_connections +
+        block_relay_connections, peers.size());
 }
 
 duration settings::connect_timeout() const
@@ -153,5 +182,35 @@ duration settings::channel_germination() const
     return seconds(channel_germination_seconds);
 }
 
+duration settings::channel_trickle() const
+{
+    return milliseconds(channel_trickle_milliseconds);
+}
+
+duration settings::transaction_request_timeout() const
+{
+    return seconds(transaction_request_timeout_seconds);
+}
+
+duration settings::block_request_timeout() const
+{
+    return seconds(block_request_timeout_seconds);
+}
+
+duration settings::block_stall_timeout() const
+{
+    return seconds(block_stall_seconds);
+}
+
+duration settings::bloom_filter_budget() const
+{
+    return milliseconds(bloom_filter_budget_milliseconds);
+}
+
+duration settings::reconciliation_interval() const
+{
+    return seconds(reconciliation_interval_seconds);
+}
+
 } // namespace network
 } // namespace libbitcoin
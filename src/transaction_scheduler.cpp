@@ -0,0 +1,495 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/transaction_scheduler.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::placeholders;
+
+// Request timeouts are checked once per second.
+static const asio::seconds timer_interval(1);
+
+// Limit retained announcements per peer, to bound memory.
+static const size_t maximum_announced = 5000;
+
+// Received transactions are ignored if subsequently announced.
+static const size_t recent_received = 50000;
+static const double recent_false_positive_rate = 0.000001;
+
+transaction_scheduler::transaction_scheduler(threadpool& pool,
+    const settings& settings)
+  : stopped_(true),
+    limit_(settings.transaction_request_limit),
+    timeout_(settings.transaction_request_timeout()),
+    timer_(std::make_shared<deadline>(pool, timer_interval)),
+    received_(recent_received, recent_false_positive_rate)
+{
+}
+
+// Start/Stop.
+// ----------------------------------------------------------------------------
+
+void transaction_scheduler::start()
+{
+    stopped_ = false;
+    start_timer();
+}
+
+void transaction_scheduler::stop()
+{
+    stopped_ = true;
+    timer_->stop();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    entries_.clear();
+    peers_.clear();
+    received_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_scheduler::set_filter(filter_handler filter)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    filter_ = filter;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Peers.
+// ----------------------------------------------------------------------------
+
+void transaction_scheduler::connect(uint64_t peer, request_handler handler)
+{
+    if (stopped_)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    peers_[peer] = { handler, 0, 0, {} };
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_scheduler::disconnect(uint64_t peer)
+{
+    requests out;
+    hash_list orphaned;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    // This also discards the transactions awaiting the peer.
+    peers_.erase(peer);
+
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        auto& item = it->second;
+        auto& candidates = item.candidates;
+        candidates.erase(std::remove(candidates.begin(), candidates.end(),
+            peer), candidates.end());
+
+        const auto requested = item.assigned && item.requested == peer;
+
+        if (requested)
+            item.assigned = false;
+
+        if (!item.assigned && candidates.empty())
+        {
+            it = entries_.erase(it);
+            continue;
+        }
+
+        if (requested)
+            orphaned.push_back(it->first);
+
+        ++it;
+    }
+
+    for (const auto& hash: orphaned)
+        schedule(hash, entries_[hash], out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+// Events.
+// ----------------------------------------------------------------------------
+
+void transaction_scheduler::announced(uint64_t peer, const hash_list& hashes)
+{
+    if (stopped_)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+    const auto filter = filter_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    hash_list wanted;
+    wanted.reserve(hashes.size());
+
+    for (const auto& hash: hashes)
+        if (!filter || filter(hash))
+            wanted.push_back(hash);
+
+    requests out;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto announcer = peers_.find(peer);
+
+    if (announcer == peers_.end())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    for (const auto& hash: wanted)
+    {
+        if (announcer->second.announced >= maximum_announced)
+            break;
+
+        if (received_.contains(hash))
+            continue;
+
+        auto& item = entries_[hash];
+        auto& candidates = item.candidates;
+
+        if ((item.assigned && item.requested == peer) || std::find(
+            candidates.begin(), candidates.end(), peer) != candidates.end())
+            continue;
+
+        candidates.push_back(peer);
+        ++announcer->second.announced;
+
+        if (!item.assigned)
+            schedule(hash, item, out);
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+void transaction_scheduler::received(uint64_t, const hash_digest& hash)
+{
+    requests out;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    received_.insert(hash);
+    erase(hash, out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+void transaction_scheduler::not_found(uint64_t peer, const hash_list& hashes)
+{
+    requests out;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    auto released = false;
+
+    for (const auto& hash: hashes)
+    {
+        const auto it = entries_.find(hash);
+
+        if (it == entries_.end() || !it->second.assigned ||
+            it->second.requested != peer)
+            continue;
+
+        release(it->second);
+        released = true;
+
+        if (it->second.candidates.empty())
+            entries_.erase(it);
+        else
+            schedule(hash, it->second, out);
+    }
+
+    if (released)
+        fill(peer, out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+}
+
+// Properties.
+// ----------------------------------------------------------------------------
+
+size_t transaction_scheduler::in_flight(uint64_t peer) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = peers_.find(peer);
+    return it == peers_.end() ? 0 : it->second.in_flight;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t transaction_scheduler::announcements() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Scheduling (must be called under lock).
+// ----------------------------------------------------------------------------
+// An unassigned transaction is assigned to its earliest announcer with
+// capacity. Otherwise it waits on each of its announcers, and is assigned
+// to the first of them that gains capacity. So each event revisits only the
+// transactions of the announcers that it affects.
+
+bool transaction_scheduler::available(uint64_t peer) const
+{
+    const auto it = peers_.find(peer);
+    return it != peers_.end() && it->second.in_flight < limit_;
+}
+
+void transaction_scheduler::schedule(const hash_digest& hash, entry& item,
+    requests& out)
+{
+    auto& candidates = item.candidates;
+    const auto next = std::find_if(candidates.begin(), candidates.end(),
+        std::bind(&transaction_scheduler::available, this, _1));
+
+    if (next != candidates.end())
+    {
+        assign(hash, item, *next, out);
+        return;
+    }
+
+    for (const auto candidate: candidates)
+    {
+        const auto announcer = peers_.find(candidate);
+
+        if (announcer != peers_.end())
+            announcer->second.waiting.insert(hash);
+    }
+}
+
+// The transaction no longer waits on any of its announcers.
+void transaction_scheduler::assign(const hash_digest& hash, entry& item,
+    uint64_t peer, requests& out)
+{
+    for (const auto candidate: item.candidates)
+    {
+        const auto announcer = peers_.find(candidate);
+
+        if (announcer != peers_.end())
+            announcer->second.waiting.erase(hash);
+    }
+
+    auto& candidates = item.candidates;
+    candidates.erase(std::find(candidates.begin(), candidates.end(), peer));
+
+    auto& announcer = peers_[peer];
+    ++announcer.in_flight;
+    --announcer.announced;
+
+    item.assigned = true;
+    item.requested = peer;
+    item.expiry = asio::steady_clock::now() + timeout_;
+    out[peer].push_back(hash);
+}
+
+// Assign waiting transactions to the peer while it has capacity.
+void transaction_scheduler::fill(uint64_t peer, requests& out)
+{
+    const auto it = peers_.find(peer);
+
+    if (it == peers_.end())
+        return;
+
+    auto& waiting = it->second.waiting;
+
+    while (!waiting.empty() && it->second.in_flight < limit_)
+    {
+        const auto hash = *waiting.begin();
+        assign(hash, entries_[hash], peer, out);
+    }
+}
+
+// Free the request slot of the peer from which the item was requested.
+void transaction_scheduler::release(entry& item)
+{
+    const auto it = peers_.find(item.requested);
+
+    if (it != peers_.end() && it->second.in_flight > 0)
+        --it->second.in_flight;
+
+    item.assigned = false;
+}
+
+void transaction_scheduler::erase(const hash_digest& hash, requests& out)
+{
+    const auto it = entries_.find(hash);
+
+    if (it == entries_.end())
+        return;
+
+    auto& item = it->second;
+    const auto assigned = item.assigned;
+    const auto requested = item.requested;
+
+    if (assigned)
+        release(item);
+
+    for (const auto candidate: item.candidates)
+    {
+        const auto announcer = peers_.find(candidate);
+
+        if (announcer == peers_.end())
+            continue;
+
+        announcer->second.waiting.erase(hash);
+
+        if (announcer->second.announced > 0)
+            --announcer->second.announced;
+    }
+
+    entries_.erase(it);
+
+    if (assigned)
+        fill(requested, out);
+}
+
+void transaction_scheduler::send(const requests& out) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+
+    std::vector<std::pair<request_handler, hash_list>> sends;
+
+    for (const auto& request: out)
+    {
+        const auto it = peers_.find(request.first);
+
+        if (it != peers_.end())
+            sends.push_back({ it->second.handler, request.second });
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& request: sends)
+        request.first(request.second);
+}
+
+// Timer.
+// ----------------------------------------------------------------------------
+
+void transaction_scheduler::start_timer()
+{
+    if (stopped_)
+        return;
+
+    timer_->start(
+        std::bind(&transaction_scheduler::handle_timer,
+            shared_from_this(), _1));
+}
+
+// Requests that time out are reassigned to the next announcer, if any.
+void transaction_scheduler::handle_timer(const code&)
+{
+    if (stopped_)
+        return;
+
+    requests out;
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    std::set<uint64_t> released;
+    hash_list expired;
+
+    for (const auto& item: entries_)
+        if (item.second.assigned && item.second.expiry <= now)
+            expired.push_back(item.first);
+
+    for (const auto& hash: expired)
+    {
+        const auto it = entries_.find(hash);
+        auto& item = it->second;
+        released.insert(item.requested);
+        release(item);
+
+        if (item.candidates.empty())
+            entries_.erase(it);
+        else
+            schedule(hash, item, out);
+    }
+
+    for (const auto peer: released)
+        fill(peer, out);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(out);
+    start_timer();
+}
+
+} // namespace network
+} // namespace libbitcoin
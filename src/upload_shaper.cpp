@@ -0,0 +1,389 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/network/upload_shaper.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network/settings.hpp>
+
+namespace libbitcoin {
+namespace network {
+
+using namespace std::placeholders;
+
+// Buckets are refilled ten times per second.
+static const uint32_t refill_milliseconds = 100;
+static const size_t refills_per_second = 1000 / refill_milliseconds;
+
+// Bytes added to the deficit of each backlogged flow per round.
+static const int64_t quantum = 65536;
+
+upload_shaper::upload_shaper(threadpool& pool, const settings& settings)
+  : stopped_(true),
+    timer_(std::make_shared<deadline>(pool,
+        asio::milliseconds(refill_milliseconds))),
+    peer_rate_(size_t(settings.peer_upload_kilobytes_per_second) * 1024),
+    timing_(false),
+    rate_(size_t(settings.upload_kilobytes_per_second) * 1024),
+    tokens_(rate_)
+{
+}
+
+// Start/Stop.
+// ----------------------------------------------------------------------------
+
+void upload_shaper::start()
+{
+    stopped_ = false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto start = claim_timer();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (start)
+        start_timer();
+}
+
+void upload_shaper::stop()
+{
+    stopped_ = true;
+    timer_->stop();
+    grants failed;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    for (const auto flow: flows_)
+    {
+        failed.insert(failed.end(), flow->pending.begin(),
+            flow->pending.end());
+        flow->pending.clear();
+        flow->deficit = 0;
+    }
+
+    active_.clear();
+    timing_ = false;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    fail(failed, error::service_stopped);
+}
+
+// Flows.
+// ----------------------------------------------------------------------------
+
+upload_shaper::flow::ptr upload_shaper::open()
+{
+    const auto rate = peer_rate_;
+    const auto flow = std::make_shared<upload_shaper::flow>(
+        upload_shaper::flow{ rate, static_cast<int64_t>(rate), 0, {} });
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    flows_.insert(flow);
+    return flow;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void upload_shaper::close(flow::ptr flow)
+{
+    grants failed;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    flows_.erase(flow);
+    active_.remove(flow);
+    failed.insert(failed.end(), flow->pending.begin(), flow->pending.end());
+    flow->pending.clear();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    fail(failed, error::channel_stopped);
+}
+
+void upload_shaper::request(flow::ptr flow, size_t bytes, bool exempt,
+    result_handler handler)
+{
+    if (stopped_)
+    {
+        handler(error::service_stopped);
+        return;
+    }
+
+    grants granted;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    if (flows_.find(flow) == flows_.end())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        handler(error::channel_stopped);
+        return;
+    }
+
+    if (exempt || (rate_ == 0 && flow->rate == 0))
+    {
+        charge(rate_, tokens_, bytes);
+        charge(flow->rate, flow->tokens, bytes);
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        handler(error::success);
+        return;
+    }
+
+    if (flow->pending.empty())
+        active_.push_back(flow);
+
+    flow->pending.push_back({ bytes, handler });
+    schedule(granted);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& grant: granted)
+        grant.second(error::success);
+}
+
+// Rates.
+// ----------------------------------------------------------------------------
+
+size_t upload_shaper::rate() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return rate_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void upload_shaper::set_rate(size_t bytes_per_second)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    rate_ = bytes_per_second;
+    tokens_ = std::min(tokens_, static_cast<int64_t>(rate_));
+    const auto start = claim_timer();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (start)
+        start_timer();
+}
+
+size_t upload_shaper::rate(flow::ptr flow) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return flow->rate;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void upload_shaper::set_rate(flow::ptr flow, size_t bytes_per_second)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    flow->rate = bytes_per_second;
+    flow->tokens = std::min(flow->tokens, static_cast<int64_t>(flow->rate));
+    const auto start = claim_timer();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (start)
+        start_timer();
+}
+
+// Token buckets.
+// ----------------------------------------------------------------------------
+// Buckets hold up to one second of their rate. A write is permitted while any
+// tokens remain, and may overdraw the bucket, so that messages larger than
+// the bucket are not stalled. The debt is repaid before the next write.
+// The increment is rounded up, so that a rate below the refill frequency
+// still refills.
+
+bool upload_shaper::available(size_t rate, int64_t tokens)
+{
+    return rate == 0 || tokens > 0;
+}
+
+void upload_shaper::charge(size_t rate, int64_t& tokens, size_t bytes)
+{
+    if (rate != 0)
+        tokens -= static_cast<int64_t>(bytes);
+}
+
+void upload_shaper::refill(size_t rate, int64_t& tokens)
+{
+    const auto limit = static_cast<int64_t>(rate);
+    const auto increment = static_cast<int64_t>(
+        (rate + refills_per_second - 1) / refills_per_second);
+    tokens = std::min(tokens + increment, limit);
+}
+
+// Deficit round robin.
+// ----------------------------------------------------------------------------
+// Each eligible backlogged flow accrues a quantum per round and may write
+// while its deficit covers the next message. Flows limited by their own
+// bucket are skipped without accrual. Rounds repeat until the global bucket
+// is exhausted or no backlogged flow is eligible. Must be called under lock.
+
+void upload_shaper::schedule(grants& out)
+{
+    auto progress = true;
+
+    while (progress && !active_.empty() && available(rate_, tokens_))
+    {
+        progress = false;
+
+        for (auto count = active_.size(); count > 0; --count)
+        {
+            const auto flow = active_.front();
+            active_.pop_front();
+
+            if (available(flow->rate, flow->tokens))
+            {
+                progress = true;
+                flow->deficit += quantum;
+
+                while (!flow->pending.empty() &&
+                    available(rate_, tokens_) &&
+                    available(flow->rate, flow->tokens) &&
+                    static_cast<int64_t>(flow->pending.front().first) <=
+                        flow->deficit)
+                {
+                    const auto bytes = flow->pending.front().first;
+                    flow->deficit -= static_cast<int64_t>(bytes);
+                    charge(rate_, tokens_, bytes);
+                    charge(flow->rate, flow->tokens, bytes);
+                    out.push_back(flow->pending.front());
+                    flow->pending.pop_front();
+                }
+            }
+
+            if (flow->pending.empty())
+                flow->deficit = 0;
+            else
+                active_.push_back(flow);
+        }
+    }
+}
+
+void upload_shaper::fail(grants& out, const code& ec)
+{
+    for (const auto& request: out)
+        request.second(ec);
+}
+
+// Timer.
+// ----------------------------------------------------------------------------
+// Buckets are unused when all rates are unlimited, so the timer is stopped
+// until a rate is set. Pending requests are granted on the final refill.
+
+// Must be called under lock.
+bool upload_shaper::limited() const
+{
+    if (rate_ != 0 || peer_rate_ != 0)
+        return true;
+
+    for (const auto flow: flows_)
+        if (flow->rate != 0)
+            return true;
+
+    return false;
+}
+
+// Must be called under lock, start the timer if this returns true.
+bool upload_shaper::claim_timer()
+{
+    if (stopped_ || timing_ || !limited())
+        return false;
+
+    timing_ = true;
+    return true;
+}
+
+void upload_shaper::start_timer()
+{
+    if (stopped_)
+        return;
+
+    timer_->start(
+        std::bind(&upload_shaper::handle_timer,
+            shared_from_this(), _1));
+}
+
+void upload_shaper::handle_timer(const code&)
+{
+    if (stopped_)
+        return;
+
+    grants granted;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    refill(rate_, tokens_);
+
+    for (const auto flow: flows_)
+        refill(flow->rate, flow->tokens);
+
+    schedule(granted);
+    timing_ = !stopped_ && limited();
+    const auto restart = timing_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& grant: granted)
+        grant.second(error::success);
+
+    if (restart)
+        start_timer();
+}
+
+} // namespace network
+} // namespace libbitcoin
@@ -0,0 +1,258 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::message;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(address_gossip_tests)
+
+// The gossip queue is bounded at ten address messages.
+static const size_t maximum_queued = 10 * max_address;
+
+static network::settings pooled()
+{
+    network::settings configuration;
+    configuration.host_pool_capacity = 1000;
+    configuration.hosts_file = "address_gossip.hosts.log";
+    boost::filesystem::remove_all(configuration.hosts_file);
+    return configuration;
+}
+
+// A distinct ipv4 address (10.0.0.0/16) timestamped at the given time.
+static network_address host(size_t index, uint32_t timestamp)
+{
+    const auto high = static_cast<uint8_t>(index >> 8);
+    const auto low = static_cast<uint8_t>(index);
+    const ip_address ip
+    {
+        {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0xff, 0xff, 0x0a, 0x00, high, low
+        }
+    };
+
+    return { timestamp, 0, ip, 8333 };
+}
+
+static network_address::list hosts_list(size_t count)
+{
+    const auto now = static_cast<uint32_t>(zulu_time());
+    network_address::list out;
+
+    for (size_t index = 0; index < count; ++index)
+        out.push_back(host(index, now));
+
+    return out;
+}
+
+static bool stored(hosts& pool, size_t count)
+{
+    for (size_t poll = 0; poll < 500 && pool.count() < count; ++poll)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    return pool.count() == count;
+}
+
+// Storage.
+
+BOOST_AUTO_TEST_CASE(address_gossip__store__not_started__not_queued)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->store(hosts_list(10));
+    BOOST_REQUIRE_EQUAL(gossip->queued(), 0u);
+}
+
+// The pool is not running, so the queue is not drained.
+BOOST_AUTO_TEST_CASE(address_gossip__store__excess__dropped_at_limit)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    gossip->store(network_address::list(maximum_queued - 1));
+    BOOST_REQUIRE_EQUAL(gossip->queued(), maximum_queued - 1);
+
+    gossip->store(network_address::list(2));
+    BOOST_REQUIRE_EQUAL(gossip->queued(), maximum_queued);
+}
+
+BOOST_AUTO_TEST_CASE(address_gossip__stop__queued__cleared)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    gossip->store(hosts_list(10));
+    BOOST_REQUIRE_EQUAL(gossip->queued(), 10u);
+
+    gossip->stop();
+    BOOST_REQUIRE_EQUAL(gossip->queued(), 0u);
+}
+
+// The queue is drained in batches (of 100) to the host pool.
+BOOST_AUTO_TEST_CASE(address_gossip__store__started__drained_to_hosts)
+{
+    threadpool pool(1);
+    hosts addresses(pooled());
+    BOOST_REQUIRE_EQUAL(addresses.start(), error::success);
+
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    gossip->store(hosts_list(250));
+    BOOST_REQUIRE(stored(addresses, 250));
+    BOOST_REQUIRE_EQUAL(gossip->queued(), 0u);
+
+    gossip->stop();
+    addresses.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+// Relay.
+
+BOOST_AUTO_TEST_CASE(address_gossip__relayable__fresh__once)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+
+    const auto fresh = hosts_list(2);
+    BOOST_REQUIRE_EQUAL(gossip->relayable(fresh).size(), 2u);
+    BOOST_REQUIRE(gossip->relayable(fresh).empty());
+    BOOST_REQUIRE_EQUAL(gossip->relayable(hosts_list(3)).size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(address_gossip__relayable__stale__excluded)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+
+    // Addresses are relayed only if timestamped within ten minutes.
+    const auto now = static_cast<uint32_t>(zulu_time());
+    const network_address::list stale{ host(1, now - 11 * 60) };
+    BOOST_REQUIRE(gossip->relayable(stale).empty());
+}
+
+BOOST_AUTO_TEST_CASE(address_gossip__relayable__invalid__excluded)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    BOOST_REQUIRE(gossip->relayable(network_address::list(1)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(address_gossip__relayable__stopped__empty)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    BOOST_REQUIRE(gossip->relayable(hosts_list(1)).empty());
+}
+
+// Sample.
+
+static void store(hosts& pool, size_t count)
+{
+    for (const auto& item: hosts_list(count))
+        BOOST_REQUIRE_EQUAL(pool.store(item), error::success);
+}
+
+BOOST_AUTO_TEST_CASE(address_gossip__sample__empty_pool__empty_not_cached)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    BOOST_REQUIRE_EQUAL(addresses.start(), error::success);
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    BOOST_REQUIRE(gossip->sample()->addresses().empty());
+
+    store(addresses, 1);
+    BOOST_REQUIRE_EQUAL(gossip->sample()->addresses().size(), 1u);
+}
+
+// A sample is 23 percent of the host pool.
+BOOST_AUTO_TEST_CASE(address_gossip__sample__pool__portion)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    BOOST_REQUIRE_EQUAL(addresses.start(), error::success);
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    store(addresses, 200);
+    BOOST_REQUIRE_EQUAL(gossip->sample()->addresses().size(), 46u);
+}
+
+BOOST_AUTO_TEST_CASE(address_gossip__sample__small_pool__one)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    BOOST_REQUIRE_EQUAL(addresses.start(), error::success);
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    store(addresses, 2);
+    BOOST_REQUIRE_EQUAL(gossip->sample()->addresses().size(), 1u);
+}
+
+// Repeated requests within the window are answered with the same sample.
+BOOST_AUTO_TEST_CASE(address_gossip__sample__repeated__cached)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    BOOST_REQUIRE_EQUAL(addresses.start(), error::success);
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    store(addresses, 100);
+
+    const auto sample = gossip->sample();
+    BOOST_REQUIRE_EQUAL(sample->addresses().size(), 23u);
+
+    for (size_t request = 0; request < 10; ++request)
+        BOOST_REQUIRE(gossip->sample() == sample);
+}
+
+BOOST_AUTO_TEST_CASE(address_gossip__sample__stopped__refreshed)
+{
+    threadpool pool;
+    hosts addresses(pooled());
+    BOOST_REQUIRE_EQUAL(addresses.start(), error::success);
+    const auto gossip = std::make_shared<address_gossip>(pool, addresses);
+    gossip->start();
+    store(addresses, 100);
+
+    const auto sample = gossip->sample();
+    gossip->stop();
+    BOOST_REQUIRE(gossip->sample() != sample);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
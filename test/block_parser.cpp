@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+static chain::transaction make_transaction(uint32_t locktime,
+    size_t script_size, bool witness)
+{
+    const chain::script script(data_chunk(script_size, 0x51), false);
+    chain::input input({ null_hash, 0 }, script, max_uint32);
+
+    if (witness)
+        input.set_witness(chain::witness({ data_chunk(script_size, 0x42),
+            data_chunk{}, data_chunk(3, 0x24) }));
+
+    return chain::transaction(1, locktime, { input },
+        { chain::output(42, script) });
+}
+
+static chain::block make_block(bool witness)
+{
+    return chain::block(chain::header{},
+    {
+        make_transaction(0, 10, false),
+        make_transaction(1, 70000, witness),
+        make_transaction(2, 300, witness)
+    });
+}
+
+BOOST_AUTO_TEST_SUITE(block_parser_tests)
+
+BOOST_AUTO_TEST_CASE(block_parser__write__whole_payload__complete)
+{
+    const auto block = make_block(false);
+    const auto data = block.to_data(true);
+    block_parser parser(data.size(), nullptr);
+    BOOST_REQUIRE_EQUAL(parser.write(data), error::success);
+    BOOST_REQUIRE_EQUAL(parser.remaining(), 0u);
+    BOOST_REQUIRE(parser.complete());
+
+    const auto result = parser.finish();
+    BOOST_REQUIRE(result->hash() == block.hash());
+    BOOST_REQUIRE_EQUAL(result->transactions().size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(block_parser__write__byte_at_a_time_witness__complete_in_order)
+{
+    const auto block = make_block(true);
+    const auto data = block.to_data(true);
+    std::vector<size_t> indexes;
+
+    const auto handler = [&](header_const_ptr header, size_t index,
+        transaction_const_ptr transaction)
+    {
+        BOOST_REQUIRE(header->hash() == block.header().hash());
+        BOOST_REQUIRE(transaction->hash(true) ==
+            block.transactions()[index].hash(true));
+        indexes.push_back(index);
+    };
+
+    block_parser parser(data.size(), handler);
+
+    for (const auto byte: data)
+        BOOST_REQUIRE_EQUAL(parser.write({ byte }), error::success);
+
+    BOOST_REQUIRE(parser.complete());
+    BOOST_REQUIRE(indexes == std::vector<size_t>({ 0, 1, 2 }));
+    BOOST_REQUIRE(parser.finish()->to_data(true) == data);
+}
+
+BOOST_AUTO_TEST_CASE(block_parser__write__chunks__complete)
+{
+    const auto block = make_block(true);
+    const auto data = block.to_data(true);
+    const size_t chunk = 4096;
+    block_parser parser(data.size(), nullptr);
+
+    for (size_t offset = 0; offset < data.size(); offset += chunk)
+    {
+        const auto end = std::min(offset + chunk, data.size());
+        BOOST_REQUIRE_EQUAL(parser.write({ data.begin() + offset,
+            data.begin() + end }), error::success);
+        BOOST_REQUIRE_EQUAL(parser.remaining(), data.size() - end);
+    }
+
+    BOOST_REQUIRE(parser.complete());
+    BOOST_REQUIRE(parser.finish()->hash() == block.hash());
+}
+
+BOOST_AUTO_TEST_CASE(block_parser__write__partial_payload__incomplete)
+{
+    const auto data = make_block(false).to_data(true);
+    block_parser parser(data.size(), nullptr);
+    BOOST_REQUIRE_EQUAL(parser.write({ data.begin(), data.end() - 1 }),
+        error::success);
+    BOOST_REQUIRE_EQUAL(parser.remaining(), 1u);
+    BOOST_REQUIRE(!parser.complete());
+}
+
+BOOST_AUTO_TEST_CASE(block_parser__write__excess_data__bad_stream)
+{
+    const auto data = make_block(false).to_data(true);
+    block_parser parser(data.size() - 1, nullptr);
+    BOOST_REQUIRE_EQUAL(parser.write(data), error::bad_stream);
+}
+
+BOOST_AUTO_TEST_CASE(block_parser__write__trailing_bytes__bad_stream)
+{
+    auto data = make_block(false).to_data(true);
+    data.push_back(0x00);
+    block_parser parser(data.size(), nullptr);
+    BOOST_REQUIRE_EQUAL(parser.write(data), error::bad_stream);
+}
+
+BOOST_AUTO_TEST_CASE(block_parser__write__missing_transaction__bad_stream)
+{
+    auto data = make_block(false).to_data(true);
+    const auto count = chain::header::satoshi_fixed_size();
+    BOOST_REQUIRE_EQUAL(data[count], 3u);
+    data[count] = 4;
+    block_parser parser(data.size(), nullptr);
+    BOOST_REQUIRE_EQUAL(parser.write(data), error::bad_stream);
+}
+
+BOOST_AUTO_TEST_CASE(block_parser__write__excessive_count__bad_stream)
+{
+    auto data = make_block(false).to_data(true);
+    const auto count = chain::header::satoshi_fixed_size();
+    data.resize(count);
+    extend_data(data, data_chunk{ 0xfe, 0xff, 0xff, 0xff, 0x00 });
+    block_parser parser(data.size() + 1000, nullptr);
+    BOOST_REQUIRE_EQUAL(parser.write(data), error::bad_stream);
+    BOOST_REQUIRE_EQUAL(parser.write({ 0x00 }), error::bad_stream);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
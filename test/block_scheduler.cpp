@@ -0,0 +1,292 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(block_scheduler_tests)
+
+static const auto hash1 = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000001");
+static const auto hash2 = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000002");
+static const auto hash3 = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000003");
+
+static const auto timeout = std::chrono::seconds(5);
+
+// Requests are sent on the calling thread, except upon timer events.
+class recorder
+{
+public:
+    block_scheduler::request_handler handler(uint64_t peer)
+    {
+        return [this, peer](const hash_list& hashes)
+        {
+            auto& list = requests[peer];
+            list.insert(list.end(), hashes.begin(), hashes.end());
+        };
+    }
+
+    size_t count(uint64_t peer)
+    {
+        return requests[peer].size();
+    }
+
+    std::map<uint64_t, hash_list> requests;
+};
+
+static void ignore_stop(const code&)
+{
+}
+
+static network::settings configuration(uint32_t window, uint32_t limit)
+{
+    network::settings value;
+    value.block_download_window = window;
+    value.block_request_limit = limit;
+    value.block_request_timeout_seconds = 60;
+    value.block_stall_seconds = 60;
+    return value;
+}
+
+class fixture
+{
+public:
+    fixture(uint32_t window=1024, uint32_t limit=16)
+      : pool(1),
+        scheduler(std::make_shared<block_scheduler>(pool,
+            configuration(window, limit)))
+    {
+        scheduler->start();
+    }
+
+    ~fixture()
+    {
+        scheduler->stop();
+        pool.shutdown();
+        pool.join();
+    }
+
+    threadpool pool;
+    block_scheduler::ptr scheduler;
+    recorder sent;
+};
+
+BOOST_AUTO_TEST_CASE(block_scheduler__enqueue__stopped__not_pending)
+{
+    threadpool pool(1);
+    const auto scheduler = std::make_shared<block_scheduler>(pool,
+        configuration(1024, 16));
+    scheduler->enqueue({ hash1 });
+    BOOST_REQUIRE_EQUAL(scheduler->pending(), 0u);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__enqueue__duplicate__pending_once)
+{
+    fixture test;
+    test.scheduler->enqueue({ hash1, hash2 });
+    test.scheduler->enqueue({ hash2 });
+    BOOST_REQUIRE_EQUAL(test.scheduler->pending(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__connect__pending__requested_in_order)
+{
+    fixture test;
+    test.scheduler->enqueue({ hash1, hash2, hash3 });
+    test.scheduler->connect(1, test.sent.handler(1), ignore_stop);
+    BOOST_REQUIRE(test.sent.requests[1] == hash_list({ hash1, hash2, hash3 }));
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__enqueue__window__requested_as_window_advances)
+{
+    fixture test(2, 16);
+    test.scheduler->connect(1, test.sent.handler(1), ignore_stop);
+    test.scheduler->enqueue({ hash1, hash2, hash3 });
+    BOOST_REQUIRE(test.sent.requests[1] == hash_list({ hash1, hash2 }));
+
+    // The window does not advance until its earliest block is received.
+    test.scheduler->received(1, hash2, 1000);
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 2u);
+
+    test.scheduler->received(1, hash1, 1000);
+    BOOST_REQUIRE(test.sent.requests[1] == hash_list({ hash1, hash2, hash3 }));
+    BOOST_REQUIRE_EQUAL(test.scheduler->pending(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__enqueue__limit__assigned_to_other_peer)
+{
+    fixture test(1024, 1);
+    test.scheduler->connect(1, test.sent.handler(1), ignore_stop);
+    test.scheduler->connect(2, test.sent.handler(2), ignore_stop);
+    test.scheduler->enqueue({ hash1, hash2, hash3 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(2), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__received__measured__prefers_faster_peer)
+{
+    fixture test(1024, 1);
+    test.scheduler->connect(1, test.sent.handler(1), ignore_stop);
+    test.scheduler->connect(2, test.sent.handler(2), ignore_stop);
+    test.scheduler->enqueue({ hash1, hash2 });
+    BOOST_REQUIRE(test.sent.requests[1] == hash_list({ hash1 }));
+    BOOST_REQUIRE(test.sent.requests[2] == hash_list({ hash2 }));
+
+    test.scheduler->received(2, hash2, 1000000);
+    BOOST_REQUIRE_GT(test.scheduler->throughput(2), 0.0);
+
+    // Both peers have capacity, the measured peer is preferred.
+    test.scheduler->received(1, hash1, 1);
+    test.scheduler->enqueue({ hash3 });
+    BOOST_REQUIRE_GT(test.scheduler->throughput(2),
+        test.scheduler->throughput(1));
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 2u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__not_found__other_peer__reassigned_and_excluded)
+{
+    fixture test(1024, 1);
+    test.scheduler->connect(1, test.sent.handler(1), ignore_stop);
+    test.scheduler->enqueue({ hash1 });
+    test.scheduler->connect(2, test.sent.handler(2), ignore_stop);
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 0u);
+
+    test.scheduler->not_found(1, { hash1 });
+    BOOST_REQUIRE(test.sent.requests[2] == hash_list({ hash1 }));
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 0u);
+
+    // The excluded peer is not asked again while another peer may be.
+    test.scheduler->not_found(2, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->pending(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__not_found__unrequested_peer__ignored)
+{
+    fixture test;
+    test.scheduler->connect(1, test.sent.handler(1), ignore_stop);
+    test.scheduler->enqueue({ hash1 });
+    test.scheduler->not_found(2, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__disconnect__in_flight__reassigned)
+{
+    fixture test(1024, 2);
+    test.scheduler->connect(1, test.sent.handler(1), ignore_stop);
+    test.scheduler->enqueue({ hash1, hash2 });
+    test.scheduler->connect(2, test.sent.handler(2), ignore_stop);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 0u);
+
+    test.scheduler->disconnect(1);
+    BOOST_REQUIRE(test.sent.requests[2] == hash_list({ hash1, hash2 }));
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(2), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__timer__stalled_window__stopped_and_reassigned)
+{
+    threadpool pool(1);
+    auto settings = configuration(1024, 1);
+    settings.block_stall_seconds = 1;
+    const auto scheduler = std::make_shared<block_scheduler>(pool, settings);
+    scheduler->start();
+
+    std::promise<code> stopped;
+    std::promise<hash_list> reassigned;
+    auto requests = 0;
+
+    scheduler->connect(1, [](const hash_list&) {},
+        [&stopped](const code& ec)
+        {
+            stopped.set_value(ec);
+        });
+
+    scheduler->connect(2, [&reassigned, &requests](const hash_list& hashes)
+        {
+            if (++requests == 2)
+                reassigned.set_value(hashes);
+        }, ignore_stop);
+
+    // The first peer holds the earliest block while the second delivers.
+    scheduler->enqueue({ hash1, hash2 });
+    scheduler->received(2, hash2, 1000);
+
+    auto stopped_future = stopped.get_future();
+    BOOST_REQUIRE(stopped_future.wait_for(timeout) ==
+        std::future_status::ready);
+    BOOST_REQUIRE_EQUAL(stopped_future.get(), error::channel_timeout);
+
+    auto reassigned_future = reassigned.get_future();
+    BOOST_REQUIRE(reassigned_future.wait_for(timeout) ==
+        std::future_status::ready);
+    BOOST_REQUIRE(reassigned_future.get() == hash_list({ hash1 }));
+
+    scheduler->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(block_scheduler__timer__all_peers_excluded__requested_again)
+{
+    threadpool pool(1);
+    auto settings = configuration(1024, 16);
+    settings.block_request_timeout_seconds = 1;
+    const auto scheduler = std::make_shared<block_scheduler>(pool, settings);
+    scheduler->start();
+
+    std::promise<hash_list> retried;
+    auto requests = 0;
+
+    scheduler->connect(1, [&retried, &requests](const hash_list& hashes)
+        {
+            if (++requests == 2)
+                retried.set_value(hashes);
+        }, ignore_stop);
+
+    scheduler->enqueue({ hash1 });
+    scheduler->not_found(1, { hash1 });
+    BOOST_REQUIRE_EQUAL(scheduler->in_flight(1), 0u);
+
+    auto future = retried.get_future();
+    BOOST_REQUIRE(future.wait_for(timeout) == std::future_status::ready);
+    BOOST_REQUIRE(future.get() == hash_list({ hash1 }));
+
+    scheduler->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+using namespace bc::message;
+
+BOOST_AUTO_TEST_SUITE(bloom_filter_tests)
+
+static const asio::duration budget = asio::seconds(1);
+
+static data_chunk chunk(const std::string& hex)
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, hex));
+    return out;
+}
+
+// A filter of one hash function (seeded by the tweak), with only the bit of
+// the given murmur3 hash set, so the element is contained if it hashes to it.
+static bool contains_hash(uint32_t seed, const data_chunk& element,
+    uint32_t hash)
+{
+    data_chunk bits(bloom_filter::maximum_filter_size, 0x00);
+    const auto bit = hash % (bits.size() * byte_bits);
+    bits[bit >> 3] |= (1 << (bit & 7));
+    const bloom_filter filter({ bits, 1, seed, 0 }, budget);
+    return filter.contains(element);
+}
+
+// The elements are contained and each set bit is required by an element,
+// so inserting the elements into an empty filter produces exactly the bits.
+static bool produces(const data_chunk& bits, uint32_t functions,
+    uint32_t tweak, const data_stack& elements)
+{
+    const bloom_filter filter({ bits, functions, tweak, 0 }, budget);
+
+    for (const auto& element: elements)
+        if (!filter.contains(element))
+            return false;
+
+    for (size_t bit = 0; bit < bits.size() * byte_bits; ++bit)
+    {
+        const uint8_t mask = 1 << (bit & 7);
+
+        if ((bits[bit >> 3] & mask) == 0)
+            continue;
+
+        auto cleared = bits;
+        cleared[bit >> 3] &= ~mask;
+        const bloom_filter reduced({ cleared, functions, tweak, 0 }, budget);
+        auto required = false;
+
+        for (const auto& element: elements)
+            required |= !reduced.contains(element);
+
+        if (!required)
+            return false;
+    }
+
+    return true;
+}
+
+static const data_stack bip37_elements
+{
+    chunk("99108ad8ed9bb6274d3980bab5a85c048f0950c8"),
+    chunk("b5a2c786d9ef4658287ced5914b37a1b4aa32eee"),
+    chunk("b9300670b4c5366e95b2699e8b18bc75e5f729c5")
+};
+
+// murmur3 (bip37 reference vectors)
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__empty__expected)
+{
+    BOOST_REQUIRE(contains_hash(0x00000000, {}, 0x00000000));
+    BOOST_REQUIRE(contains_hash(0xfba4c795, {}, 0x6a396f08));
+    BOOST_REQUIRE(contains_hash(0xffffffff, {}, 0x81f16f39));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__tail__expected)
+{
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("00"), 0x514e28b7));
+    BOOST_REQUIRE(contains_hash(0xfba4c795, chunk("00"), 0xea3f0b17));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("ff"), 0xfd6cf10d));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("0011"), 0x16c6b7ab));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("001122"), 0x8eb51c3d));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__blocks__expected)
+{
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("00112233"), 0xb4471bf8));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("0011223344"),
+        0xe2301fa8));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("001122334455"),
+        0xfc2e4a15));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("00112233445566"),
+        0xb074502c));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("0011223344556677"),
+        0x8034d2a0));
+    BOOST_REQUIRE(contains_hash(0x00000000, chunk("001122334455667788"),
+        0xb4698def));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__other_hash__not_contained)
+{
+    BOOST_REQUIRE(!contains_hash(0x00000000, chunk("00"), 0x514e28b8));
+    BOOST_REQUIRE(!contains_hash(0x00000000, chunk("00112233"), 0xb4471bf7));
+}
+
+// filter (bip37 reference vectors)
+
+BOOST_AUTO_TEST_CASE(bloom_filter__insert__reference_elements__contained)
+{
+    bloom_filter filter({ data_chunk(3, 0x00), 5, 0, 1 }, budget);
+
+    for (const auto& element: bip37_elements)
+        filter.insert(element);
+
+    for (const auto& element: bip37_elements)
+        BOOST_REQUIRE(filter.contains(element));
+
+    BOOST_REQUIRE(!filter.contains(
+        chunk("19108ad8ed9bb6274d3980bab5a85c048f0950c8")));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__insert__reference_elements__expected_bits)
+{
+    BOOST_REQUIRE(produces(chunk("614e9b"), 5, 0, bip37_elements));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__insert__reference_elements_tweaked__expected_bits)
+{
+    BOOST_REQUIRE(produces(chunk("ce4299"), 5, 2147483649, bip37_elements));
+}
+
+// limits
+
+BOOST_AUTO_TEST_CASE(bloom_filter__valid__limits__expected)
+{
+    const auto size = bloom_filter::maximum_filter_size;
+    const auto functions = static_cast<uint32_t>(
+        bloom_filter::maximum_hash_functions);
+
+    BOOST_REQUIRE(bloom_filter::valid({ data_chunk(size), functions, 0, 0 }));
+    BOOST_REQUIRE(!bloom_filter::valid({ data_chunk(size + 1), functions, 0,
+        0 }));
+    BOOST_REQUIRE(!bloom_filter::valid({ data_chunk(size), functions + 1, 0,
+        0 }));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__empty_and_full__expected)
+{
+    const bloom_filter empty({ data_chunk(3, 0x00), 5, 0, 0 }, budget);
+    const bloom_filter full({ data_chunk(3, 0xff), 5, 0, 0 }, budget);
+    BOOST_REQUIRE(!empty.contains(bip37_elements.front()));
+    BOOST_REQUIRE(full.contains(bip37_elements.front()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(compact_block_relay_tests)
+
+static hash_digest block_hash(uint32_t index)
+{
+    return sha256_hash(to_little_endian(index));
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_relay__select__three_peers__fourth_refused)
+{
+    compact_block_relay relay;
+    BOOST_REQUIRE(relay.select(1));
+    BOOST_REQUIRE(relay.select(2));
+    BOOST_REQUIRE(relay.select(3));
+    BOOST_REQUIRE(!relay.select(4));
+    BOOST_REQUIRE_EQUAL(relay.high_bandwidth(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_relay__select__selected_peer__true)
+{
+    compact_block_relay relay;
+    BOOST_REQUIRE(relay.select(1));
+    BOOST_REQUIRE(relay.select(1));
+    BOOST_REQUIRE_EQUAL(relay.high_bandwidth(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_relay__disconnect__selected__slot_released)
+{
+    compact_block_relay relay;
+    BOOST_REQUIRE(relay.select(1));
+    BOOST_REQUIRE(relay.select(2));
+    BOOST_REQUIRE(relay.select(3));
+    relay.disconnect(2);
+    BOOST_REQUIRE_EQUAL(relay.high_bandwidth(), 2u);
+    BOOST_REQUIRE(relay.select(4));
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_relay__claim__claimed_by_other__false)
+{
+    compact_block_relay relay;
+    BOOST_REQUIRE(relay.claim(1, block_hash(0)));
+    BOOST_REQUIRE(relay.claim(1, block_hash(0)));
+    BOOST_REQUIRE(!relay.claim(2, block_hash(0)));
+    BOOST_REQUIRE(relay.claim(2, block_hash(1)));
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_relay__claim__completed__false)
+{
+    compact_block_relay relay;
+    BOOST_REQUIRE(relay.claim(1, block_hash(0)));
+    relay.completed(block_hash(0));
+    BOOST_REQUIRE(!relay.claim(1, block_hash(0)));
+    BOOST_REQUIRE(!relay.claim(2, block_hash(0)));
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_relay__claim__completed_unclaimed__false)
+{
+    compact_block_relay relay;
+    relay.completed(block_hash(0));
+    BOOST_REQUIRE(!relay.claim(1, block_hash(0)));
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_relay__disconnect__claimed__claim_released)
+{
+    compact_block_relay relay;
+    BOOST_REQUIRE(relay.claim(1, block_hash(0)));
+    relay.disconnect(1);
+    BOOST_REQUIRE(relay.claim(2, block_hash(0)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
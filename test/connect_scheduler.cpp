@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(connect_scheduler_tests)
+
+// The default connect timeout is five seconds.
+static const network::settings defaults;
+static const asio::duration second = asio::seconds(1);
+static const asio::duration half_second = asio::milliseconds(500);
+
+static config::endpoint host(uint16_t port)
+{
+    return { "127.0.0.1", port };
+}
+
+// Backoff.
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__delay__unknown_host__zero)
+{
+    const connect_scheduler scheduler(defaults);
+    BOOST_REQUIRE(scheduler.delay(host(1)) == asio::duration::zero());
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__delay__one_failure__jittered_connect_timeout)
+{
+    connect_scheduler scheduler(defaults);
+    scheduler.failed(host(1));
+
+    // Jitter reduces the delay by up to half.
+    const auto delay = scheduler.delay(host(1));
+    BOOST_REQUIRE(delay <= defaults.connect_timeout());
+    BOOST_REQUIRE(delay >= defaults.connect_timeout() / 2 - second);
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__delay__two_failures__doubled)
+{
+    connect_scheduler scheduler(defaults);
+    scheduler.failed(host(1));
+    scheduler.failed(host(1));
+
+    const auto delay = scheduler.delay(host(1));
+    BOOST_REQUIRE(delay <= 2 * defaults.connect_timeout());
+    BOOST_REQUIRE(delay >= defaults.connect_timeout() - second);
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__delay__many_failures__capped_at_ten_minutes)
+{
+    const asio::duration cap = asio::minutes(10);
+    connect_scheduler scheduler(defaults);
+
+    for (size_t failure = 0; failure < 100; ++failure)
+        scheduler.failed(host(1));
+
+    const auto delay = scheduler.delay(host(1));
+    BOOST_REQUIRE(delay <= cap);
+    BOOST_REQUIRE(delay >= cap / 2 - second);
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__delay__simultaneous_failures__jittered)
+{
+    connect_scheduler scheduler(defaults);
+    std::set<asio::duration::rep> delays;
+
+    for (uint16_t port = 1; port <= 100; ++port)
+        scheduler.failed(host(port));
+
+    for (uint16_t port = 1; port <= 100; ++port)
+        delays.insert(scheduler.delay(host(port)).count());
+
+    BOOST_REQUIRE_GT(delays.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__delay__succeeded__reset)
+{
+    connect_scheduler scheduler(defaults);
+    scheduler.failed(host(1));
+    scheduler.failed(host(2));
+    scheduler.succeeded(host(1));
+    BOOST_REQUIRE(scheduler.delay(host(1)) == asio::duration::zero());
+    BOOST_REQUIRE(scheduler.delay(host(2)) != asio::duration::zero());
+
+    // The failure count is also reset.
+    scheduler.failed(host(1));
+    BOOST_REQUIRE(scheduler.delay(host(1)) <= defaults.connect_timeout());
+}
+
+// Timeout.
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__timeout__unsampled__connect_timeout)
+{
+    const connect_scheduler scheduler(defaults);
+    BOOST_REQUIRE(scheduler.timeout() == defaults.connect_timeout());
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__timeout__fast_round_trip__floor)
+{
+    connect_scheduler scheduler(defaults);
+    scheduler.sampled(asio::milliseconds(10));
+    BOOST_REQUIRE(scheduler.timeout() == half_second);
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__timeout__slow_round_trip__ceiling)
+{
+    connect_scheduler scheduler(defaults);
+    scheduler.sampled(asio::seconds(30));
+    BOOST_REQUIRE(scheduler.timeout() == defaults.connect_timeout());
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__timeout__first_sample__round_trip_plus_variation)
+{
+    // The first sample sets the variation to half the round trip (rfc6298).
+    connect_scheduler scheduler(defaults);
+    scheduler.sampled(asio::milliseconds(400));
+    BOOST_REQUIRE(scheduler.timeout() == asio::milliseconds(1200));
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__timed_out__sampled__doubled_to_ceiling)
+{
+    connect_scheduler scheduler(defaults);
+    scheduler.sampled(asio::milliseconds(10));
+    scheduler.timed_out();
+    BOOST_REQUIRE(scheduler.timeout() == 2 * half_second);
+    scheduler.timed_out();
+    BOOST_REQUIRE(scheduler.timeout() == 4 * half_second);
+    scheduler.timed_out();
+    scheduler.timed_out();
+    BOOST_REQUIRE(scheduler.timeout() == defaults.connect_timeout());
+}
+
+BOOST_AUTO_TEST_CASE(connect_scheduler__timeout__zero_connect_timeout__floor)
+{
+    auto configuration = defaults;
+    configuration.connect_timeout_seconds = 0;
+    const connect_scheduler scheduler(configuration);
+    BOOST_REQUIRE(scheduler.timeout() == half_second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
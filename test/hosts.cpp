@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::message;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(hosts_tests)
+
+static network::settings anchored()
+{
+    network::settings configuration;
+    configuration.host_pool_capacity = 42;
+    configuration.hosts_file = "hosts_tests.hosts.log";
+    configuration.anchors_file = "hosts_tests.anchors.log";
+    return configuration;
+}
+
+static void remove_files(const network::settings& configuration)
+{
+    boost::filesystem::remove_all(configuration.hosts_file);
+    boost::filesystem::remove_all(configuration.anchors_file);
+}
+
+// A distinct ipv4 address (10.0.0.1 and up).
+static network_address host(size_t index)
+{
+    const auto low = static_cast<uint8_t>(index + 1);
+    const ip_address ip
+    {
+        {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0xff, 0xff, 0x0a, 0x00, 0x00, low
+        }
+    };
+
+    return { 0, 0, ip, 8333 };
+}
+
+static bool same(const network_address& left, const network_address& right)
+{
+    return left.ip() == right.ip() && left.port() == right.port();
+}
+
+BOOST_AUTO_TEST_CASE(hosts__fetch_anchor__none_saved__not_found)
+{
+    const auto configuration = anchored();
+    remove_files(configuration);
+    hosts instance(configuration);
+    BOOST_REQUIRE_EQUAL(instance.start(), error::success);
+
+    network_address anchor;
+    BOOST_REQUIRE_EQUAL(instance.fetch_anchor(anchor), error::not_found);
+    BOOST_REQUIRE_EQUAL(instance.stop(), error::success);
+    BOOST_REQUIRE(!boost::filesystem::exists(configuration.anchors_file));
+}
+
+BOOST_AUTO_TEST_CASE(hosts__fetch_anchor__stopped__service_stopped)
+{
+    const auto configuration = anchored();
+    remove_files(configuration);
+    hosts instance(configuration);
+
+    network_address anchor;
+    BOOST_REQUIRE_EQUAL(instance.fetch_anchor(anchor),
+        error::service_stopped);
+}
+
+// Anchors saved upon stop are fetched in rank order upon the next start.
+BOOST_AUTO_TEST_CASE(hosts__save_anchors__restart__fetched_in_order)
+{
+    const auto configuration = anchored();
+    remove_files(configuration);
+
+    hosts first(configuration);
+    BOOST_REQUIRE_EQUAL(first.start(), error::success);
+    first.save_anchors({ host(2), host(0), host(1) });
+    BOOST_REQUIRE_EQUAL(first.stop(), error::success);
+    BOOST_REQUIRE(boost::filesystem::exists(configuration.anchors_file));
+
+    hosts second(configuration);
+    BOOST_REQUIRE_EQUAL(second.start(), error::success);
+
+    network_address anchor;
+    BOOST_REQUIRE_EQUAL(second.fetch_anchor(anchor), error::success);
+    BOOST_REQUIRE(same(anchor, host(2)));
+    BOOST_REQUIRE_EQUAL(second.fetch_anchor(anchor), error::success);
+    BOOST_REQUIRE(same(anchor, host(0)));
+    BOOST_REQUIRE_EQUAL(second.fetch_anchor(anchor), error::success);
+    BOOST_REQUIRE(same(anchor, host(1)));
+    BOOST_REQUIRE_EQUAL(second.fetch_anchor(anchor), error::not_found);
+    BOOST_REQUIRE_EQUAL(second.stop(), error::success);
+}
+
+// Anchors are dialed once, so the file is removed upon load.
+BOOST_AUTO_TEST_CASE(hosts__start__anchors_loaded__file_removed)
+{
+    const auto configuration = anchored();
+    remove_files(configuration);
+
+    hosts first(configuration);
+    BOOST_REQUIRE_EQUAL(first.start(), error::success);
+    first.save_anchors({ host(0) });
+    BOOST_REQUIRE_EQUAL(first.stop(), error::success);
+
+    hosts second(configuration);
+    BOOST_REQUIRE_EQUAL(second.start(), error::success);
+    BOOST_REQUIRE(!boost::filesystem::exists(configuration.anchors_file));
+
+    network_address anchor;
+    BOOST_REQUIRE_EQUAL(second.fetch_anchor(anchor), error::success);
+    BOOST_REQUIRE_EQUAL(second.stop(), error::success);
+    BOOST_REQUIRE(!boost::filesystem::exists(configuration.anchors_file));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -177,6 +177,70 @@ static int send_result(const Message& message, p2p& network, int channels)
     return result;
 }
 
+// A dns seed stand-in, which yields the given address records for any seed
+// without use of the system resolver.
+class dns_seed_stand_in
+  : public session_seed
+{
+public:
+    dns_seed_stand_in(p2p& network, const network_address::list& records)
+      : session_seed(network), records_(records)
+    {
+    }
+
+protected:
+    void resolve_seed(const config::endpoint& seed,
+        result_handler handler) override
+    {
+        store_resolved(records_, seed, handler);
+    }
+
+private:
+    const network_address::list records_;
+};
+
+class dns_seeded_p2p
+  : public p2p
+{
+public:
+    dns_seeded_p2p(const network::settings& settings,
+        const network_address::list& records)
+      : p2p(settings), records_(records)
+    {
+    }
+
+protected:
+    session_seed::ptr attach_seed_session() override
+    {
+        return attach<dns_seed_stand_in>(records_);
+    }
+
+private:
+    const network_address::list records_;
+};
+
+// Distinct ipv4 addresses (10.0.0.1 and up).
+static network_address::list dns_records(size_t count)
+{
+    network_address::list records;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto low = static_cast<uint8_t>(index + 1);
+        const ip_address ip
+        {
+            {
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0xff, 0xff, 0x0a, 0x00, 0x00, low
+            }
+        };
+
+        records.push_back({ 0, 0, ip, 18333 });
+    }
+
+    return records;
+}
+
 // Trivial tests just validate static inits (required because p2p tests disabled in travis).
 BOOST_AUTO_TEST_SUITE(empty_tests)
 
@@ -315,6 +379,57 @@ BOOST_AUTO_TEST_CASE(p2p__start__seed_session_expiration_timeout__start_peer_thr
     BOOST_REQUIRE(network.stop());
 }
 
+BOOST_AUTO_TEST_CASE(p2p__start__seed_session_all_seeds_refused__start_peer_throttling_stop_success)
+{
+    print_headers(TEST_NAME);
+    SETTINGS_TESTNET_ONE_THREAD_NO_CONNECTIONS(configuration);
+    configuration.host_pool_capacity = 42;
+    configuration.hosts_file = get_log_path(TEST_NAME, "hosts");
+    configuration.dns_seeding = false;
+    configuration.seeds = { { "127.0.0.1:1" }, { "127.0.0.1:2" } };
+    p2p network(configuration);
+
+    // Every seed fails, so no seed generates an increase of 100 addresses.
+    BOOST_REQUIRE_EQUAL(start_result(network), error::peer_throttling);
+    BOOST_REQUIRE(network.stop());
+}
+
+BOOST_AUTO_TEST_CASE(p2p__start__dns_seed_record_per_outbound__start_success_stop_success)
+{
+    print_headers(TEST_NAME);
+    SETTINGS_TESTNET_ONE_THREAD_NO_CONNECTIONS(configuration);
+    configuration.host_pool_capacity = 42;
+    configuration.outbound_connections = 8;
+    configuration.hosts_file = get_log_path(TEST_NAME, "hosts");
+    configuration.dns_seeding = true;
+    configuration.seeds = { { "127.0.0.1:1" } };
+    dns_seeded_p2p network(configuration, dns_records(8));
+
+    // Resolution yields an address for each outbound connection, so the seed
+    // is not contacted.
+    BOOST_REQUIRE_EQUAL(start_result(network), error::success);
+    BOOST_REQUIRE_EQUAL(network.address_count(), 8u);
+    BOOST_REQUIRE(network.stop());
+}
+
+BOOST_AUTO_TEST_CASE(p2p__start__dns_seed_too_few_records__start_peer_throttling_stop_success)
+{
+    print_headers(TEST_NAME);
+    SETTINGS_TESTNET_ONE_THREAD_NO_CONNECTIONS(configuration);
+    configuration.host_pool_capacity = 42;
+    configuration.outbound_connections = 8;
+    configuration.hosts_file = get_log_path(TEST_NAME, "hosts");
+    configuration.dns_seeding = true;
+    configuration.seeds = { { "127.0.0.1:1" } };
+    dns_seeded_p2p network(configuration, dns_records(2));
+
+    // Resolution yields too few addresses, so the seed is contacted, which
+    // refuses the connection.
+    BOOST_REQUIRE_EQUAL(start_result(network), error::peer_throttling);
+    BOOST_REQUIRE_EQUAL(network.address_count(), 2u);
+    BOOST_REQUIRE(network.stop());
+}
+
 // Disabled for live test reliability.
 // This may fail due to missing blacklist entries for the specified host.
 ////BOOST_AUTO_TEST_CASE(p2p__start__seed_session_blacklisted__start_operation_fail_stop_success)
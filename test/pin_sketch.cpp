@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(pin_sketch_tests)
+
+// Distinct nonzero elements spread across the field.
+static uint32_t element(uint32_t index)
+{
+    return index * 0x9e3779b1 + 1;
+}
+
+static pin_sketch::elements sorted(pin_sketch::elements values)
+{
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__decode__empty__true_empty)
+{
+    const pin_sketch sketch(8);
+    pin_sketch::elements out{ 42 };
+    BOOST_REQUIRE(sketch.decode(out));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__decode__up_to_capacity__round_trip)
+{
+    const size_t capacity = 8;
+
+    for (uint32_t count = 1; count <= capacity; ++count)
+    {
+        pin_sketch sketch(capacity);
+        pin_sketch::elements in;
+
+        for (uint32_t index = 0; index < count; ++index)
+        {
+            sketch.add(element(index));
+            in.push_back(element(index));
+        }
+
+        pin_sketch::elements out;
+        BOOST_REQUIRE(sketch.decode(out));
+        BOOST_REQUIRE(sorted(out) == sorted(in));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__decode__over_capacity__false)
+{
+    const size_t capacity = 8;
+
+    for (uint32_t count = capacity + 1; count <= 2 * capacity; ++count)
+    {
+        pin_sketch sketch(capacity);
+
+        for (uint32_t index = 0; index < count; ++index)
+            sketch.add(element(index));
+
+        pin_sketch::elements out;
+        BOOST_REQUIRE(!sketch.decode(out));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__add__twice__removed)
+{
+    pin_sketch sketch(4);
+    sketch.add(element(0));
+    sketch.add(element(1));
+    sketch.add(element(0));
+
+    pin_sketch::elements out;
+    BOOST_REQUIRE(sketch.decode(out));
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE_EQUAL(out.front(), element(1));
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__add__zero__ignored)
+{
+    pin_sketch sketch(4);
+    sketch.add(0);
+    BOOST_REQUIRE(sketch.to_data() == pin_sketch(4).to_data());
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__merge__large_sets__symmetric_difference)
+{
+    pin_sketch local(4);
+    pin_sketch remote(4);
+
+    for (uint32_t index = 0; index < 100; ++index)
+    {
+        local.add(element(index));
+
+        if (index != 5 && index != 7)
+            remote.add(element(index));
+    }
+
+    remote.add(element(200));
+    BOOST_REQUIRE(local.merge(remote));
+
+    pin_sketch::elements out;
+    BOOST_REQUIRE(local.decode(out));
+    BOOST_REQUIRE(sorted(out) ==
+        sorted({ element(5), element(7), element(200) }));
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__merge__capacity_mismatch__false)
+{
+    pin_sketch sketch(4);
+    BOOST_REQUIRE(!sketch.merge(pin_sketch(5)));
+}
+
+BOOST_AUTO_TEST_CASE(pin_sketch__to_data__round_trip__equal)
+{
+    pin_sketch sketch(6);
+
+    for (uint32_t index = 0; index < 3; ++index)
+        sketch.add(element(index));
+
+    const auto data = sketch.to_data();
+    BOOST_REQUIRE_EQUAL(data.size(), 6u * sizeof(uint32_t));
+
+    const pin_sketch copy(data);
+    BOOST_REQUIRE_EQUAL(copy.capacity(), 6u);
+    BOOST_REQUIRE(copy.to_data() == data);
+
+    pin_sketch::elements out;
+    BOOST_REQUIRE(copy.decode(out));
+    BOOST_REQUIRE(sorted(out) ==
+        sorted({ element(0), element(1), element(2) }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(protocol_address_31402_tests)
+
+// Tokens accrue at 0.1 per second, up to one address message (1000).
+
+BOOST_AUTO_TEST_CASE(protocol_address_31402__admit__within_tokens__all)
+{
+    auto tokens = 10.0;
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, 0, 4), 4u);
+    BOOST_REQUIRE_EQUAL(tokens, 6.0);
+}
+
+BOOST_AUTO_TEST_CASE(protocol_address_31402__admit__beyond_tokens__tokens)
+{
+    auto tokens = 1.0;
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, 0, 10), 1u);
+    BOOST_REQUIRE_EQUAL(tokens, 0.0);
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, 0, 10), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(protocol_address_31402__admit__ten_seconds__one)
+{
+    auto tokens = 0.0;
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, 10000, 10), 1u);
+    BOOST_REQUIRE_EQUAL(tokens, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(protocol_address_31402__admit__fraction__accrues)
+{
+    auto tokens = 0.0;
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, 5000, 1), 0u);
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, 5000, 1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(protocol_address_31402__admit__long_idle__capped_at_one_message)
+{
+    auto tokens = 0.0;
+    const size_t day = 24 * 60 * 60 * 1000;
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, day, 5000),
+        1000u);
+    BOOST_REQUIRE_EQUAL(tokens, 0.0);
+}
+
+// The response to get_address is admitted in addition to accrued tokens.
+BOOST_AUTO_TEST_CASE(protocol_address_31402__admit__above_maximum__not_refilled)
+{
+    auto tokens = 1001.0;
+    BOOST_REQUIRE_EQUAL(protocol_address_31402::admit(tokens, 10000, 5000),
+        1001u);
+    BOOST_REQUIRE_EQUAL(tokens, 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
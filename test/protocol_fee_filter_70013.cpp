@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <set>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(protocol_fee_filter_70013_tests)
+
+// Each rounding is randomly to one of two buckets.
+static const size_t rounds = 100;
+
+BOOST_AUTO_TEST_CASE(protocol_fee_filter_70013__round_fee__zero__zero)
+{
+    BOOST_REQUIRE_EQUAL(protocol_fee_filter_70013::round_fee(0), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(protocol_fee_filter_70013__round_fee__lowest_bucket__unchanged)
+{
+    for (size_t round = 0; round < rounds; ++round)
+        BOOST_REQUIRE_EQUAL(protocol_fee_filter_70013::round_fee(1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(protocol_fee_filter_70013__round_fee__1000__bucket_or_lower_bucket)
+{
+    std::set<uint64_t> rounded;
+
+    for (size_t round = 0; round < rounds; ++round)
+        rounded.insert(protocol_fee_filter_70013::round_fee(1000));
+
+    BOOST_REQUIRE(rounded == std::set<uint64_t>({ 868, 955 }));
+}
+
+BOOST_AUTO_TEST_CASE(protocol_fee_filter_70013__round_fee__various__not_above_rate)
+{
+    for (const uint64_t rate: { 2u, 10u, 999u, 123456u, 100000000u })
+    {
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            const auto rounded = protocol_fee_filter_70013::round_fee(rate);
+            BOOST_REQUIRE_LE(rounded, rate);
+
+            // At most two buckets of ten percent spacing below the rate.
+            BOOST_REQUIRE_GT(rounded * 121 / 100 + 1, rate * 99 / 100);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(protocol_fee_filter_70013__changed__same__false)
+{
+    BOOST_REQUIRE(!protocol_fee_filter_70013::changed(0, 0));
+    BOOST_REQUIRE(!protocol_fee_filter_70013::changed(1000, 1000));
+}
+
+BOOST_AUTO_TEST_CASE(protocol_fee_filter_70013__changed__within_band__false)
+{
+    BOOST_REQUIRE(!protocol_fee_filter_70013::changed(1000, 750));
+    BOOST_REQUIRE(!protocol_fee_filter_70013::changed(1000, 1333));
+}
+
+BOOST_AUTO_TEST_CASE(protocol_fee_filter_70013__changed__beyond_band__true)
+{
+    BOOST_REQUIRE(protocol_fee_filter_70013::changed(1000, 749));
+    BOOST_REQUIRE(protocol_fee_filter_70013::changed(1000, 1334));
+    BOOST_REQUIRE(protocol_fee_filter_70013::changed(0, 1));
+    BOOST_REQUIRE(protocol_fee_filter_70013::changed(1, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::message;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(protocol_reconciliation_70014_tests)
+
+static const uint16_t responder_port = 18446;
+static const size_t common_count = 100;
+static const size_t unique_count = 5;
+
+static network::settings reconciling_settings(const std::string& name)
+{
+    auto configuration = network::settings(bc::config::settings::testnet);
+    configuration.threads = 2;
+    configuration.outbound_connections = 0;
+    configuration.host_pool_capacity = 0;
+    configuration.relay_transactions = true;
+    configuration.reconcile_transactions = true;
+    configuration.reconciliation_interval_seconds = 2;
+    configuration.reconciliation_fanout = 0;
+    configuration.hosts_file = name + ".hosts.log";
+    boost::filesystem::remove_all(configuration.hosts_file);
+    return configuration;
+}
+
+static int start_run_result(p2p& network)
+{
+    std::promise<code> started;
+    network.start([&started](code ec)
+    {
+        started.set_value(ec);
+    });
+
+    const auto result = started.get_future().get();
+    if (result)
+        return result.value();
+
+    std::promise<code> ran;
+    network.run([&ran](code ec)
+    {
+        ran.set_value(ec);
+    });
+
+    return ran.get_future().get().value();
+}
+
+static bool reconciling(channel::ptr channel)
+{
+    for (size_t poll = 0; poll < 500 && !channel->reconciliation(); ++poll)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    return !!channel->reconciliation();
+}
+
+static inventory_vector::list transactions(size_t count, uint8_t tag)
+{
+    inventory_vector::list items;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        auto hash = null_hash;
+        hash[0] = tag;
+        hash[1] = static_cast<uint8_t>(index);
+        items.push_back({ inventory::type_id::transaction, hash });
+    }
+
+    return items;
+}
+
+static size_t inventory_bytes(size_t count)
+{
+    const inventory message(inventory_vector::list(count,
+        { inventory::type_id::transaction, null_hash }));
+    return heading::maximum_size() +
+        message.serialized_size(version::level::maximum);
+}
+
+// The transaction announcements received by a channel, and their bytes
+// (of reconciliation and inventory messages).
+class announcements
+{
+public:
+    void subscribe(channel::ptr channel)
+    {
+        channel->subscribe_raw([this](const code& ec, const heading& head,
+            proxy::data_ptr payload)
+        {
+            if (ec)
+                return false;
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            bytes_ += heading::maximum_size() + payload->size();
+            return true;
+        });
+
+        channel->subscribe<inventory>([this](const code& ec,
+            inventory_const_ptr message)
+        {
+            if (ec)
+                return false;
+
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            bytes_ += heading::maximum_size() +
+                message->serialized_size(version::level::maximum);
+
+            for (const auto& item: message->inventories())
+                if (item.is_transaction_type())
+                    hashes_.insert(item.hash());
+
+            condition_.notify_all();
+            return true;
+        });
+    }
+
+    bool wait(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return condition_.wait_for(lock, std::chrono::seconds(20),
+            [this, count]() { return hashes_.size() >= count; });
+    }
+
+    std::set<hash_digest> hashes() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return hashes_;
+    }
+
+    size_t bytes() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+private:
+    size_t bytes_ = 0;
+    std::set<hash_digest> hashes_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+// Two nodes on the loopback share common_count transactions and each has
+// unique_count others. Only the unique transactions are announced, with
+// fewer bytes than flooding inventory of all transactions both ways.
+BOOST_AUTO_TEST_CASE(protocol_reconciliation_70014__two_nodes__common_not_announced_fewer_bytes)
+{
+    // These outlive the networks, which invoke their handlers upon stop.
+    announcements to_responder;
+    announcements to_initiator;
+
+    auto responder_settings = reconciling_settings("responder");
+    responder_settings.inbound_port = responder_port;
+    responder_settings.inbound_connections = 1;
+    p2p responder(responder_settings);
+
+    const auto initiator_settings = reconciling_settings("initiator");
+    p2p initiator(initiator_settings);
+
+    std::promise<channel::ptr> accepted;
+    BOOST_REQUIRE_EQUAL(start_run_result(responder), error::success);
+    responder.subscribe_connection([&accepted](code ec, channel::ptr channel)
+    {
+        accepted.set_value(ec ? nullptr : channel);
+        return false;
+    });
+
+    std::promise<channel::ptr> connected;
+    BOOST_REQUIRE_EQUAL(start_run_result(initiator), error::success);
+    initiator.connect("127.0.0.1", responder_port,
+        [&connected](code ec, channel::ptr channel)
+        {
+            connected.set_value(ec ? nullptr : channel);
+        });
+
+    const auto inbound = accepted.get_future().get();
+    const auto outbound = connected.get_future().get();
+    BOOST_REQUIRE(inbound);
+    BOOST_REQUIRE(outbound);
+    BOOST_REQUIRE(reconciling(inbound));
+    BOOST_REQUIRE(reconciling(outbound));
+
+    to_responder.subscribe(inbound);
+    to_initiator.subscribe(outbound);
+
+    const auto common = transactions(common_count, 0);
+    const auto responder_only = transactions(unique_count, 1);
+    const auto initiator_only = transactions(unique_count, 2);
+    responder.announce(common);
+    responder.announce(responder_only);
+    initiator.announce(common);
+    initiator.announce(initiator_only);
+
+    BOOST_REQUIRE(to_responder.wait(unique_count));
+    BOOST_REQUIRE(to_initiator.wait(unique_count));
+
+    std::set<hash_digest> expected_responder;
+    std::set<hash_digest> expected_initiator;
+
+    for (const auto& item: initiator_only)
+        expected_responder.insert(item.hash());
+
+    for (const auto& item: responder_only)
+        expected_initiator.insert(item.hash());
+
+    BOOST_REQUIRE(to_responder.hashes() == expected_responder);
+    BOOST_REQUIRE(to_initiator.hashes() == expected_initiator);
+
+    // Flooding announces each set in full to the other node.
+    const auto flooded = 2 * inventory_bytes(common_count + unique_count);
+    const auto reconciled = to_responder.bytes() + to_initiator.bytes();
+    BOOST_REQUIRE_LT(reconciled, flooded);
+
+    BOOST_REQUIRE(initiator.stop());
+    BOOST_REQUIRE(responder.stop());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,427 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(proxy_tests)
+
+// A proxy without timers or protocols.
+class test_proxy
+  : public proxy
+{
+public:
+    test_proxy(threadpool& pool, bc::socket::ptr socket,
+        const network::settings& settings)
+      : proxy(pool, socket, settings)
+    {
+    }
+
+protected:
+    void signal_activity() override
+    {
+    }
+
+    void handle_stopping() override
+    {
+    }
+};
+
+// Connect a proxy socket to the peer socket over the loopback interface.
+// The connection completes synchronously, so the proxy threadpool need not
+// be running. Until it runs no write completes, so sends remain queued.
+static bc::socket::ptr connect(threadpool& pool, asio::socket& peer)
+{
+    using namespace boost::asio::ip;
+    const tcp::endpoint loopback(address_v4::loopback(), 0);
+    asio::acceptor acceptor(peer.get_io_service(), loopback);
+    const auto socket = std::make_shared<bc::socket>(pool);
+    socket->get().connect(acceptor.local_endpoint());
+    acceptor.accept(peer);
+    return socket;
+}
+
+// Read one framed message from the peer socket.
+static message::heading read_message(asio::socket& peer, data_chunk& payload)
+{
+    data_chunk buffer(message::heading::maximum_size());
+    boost::asio::read(peer, boost::asio::buffer(buffer));
+    const auto head = message::heading::factory(buffer);
+    payload.resize(head.payload_size());
+    boost::asio::read(peer, boost::asio::buffer(payload));
+    return head;
+}
+
+static std::vector<std::string> read_commands(asio::socket& peer,
+    size_t count)
+{
+    data_chunk payload;
+    std::vector<std::string> commands;
+
+    for (size_t index = 0; index < count; ++index)
+        commands.push_back(read_message(peer, payload).command());
+
+    return commands;
+}
+
+static void ignore(const code&)
+{
+}
+
+// A transaction without witness, with one input and one output.
+static message::transaction::ptr make_transaction()
+{
+    static const std::string encoded =
+        "01000000"
+        "01"
+        "0000000000000000000000000000000000000000000000000000000000000000"
+        "00000000"
+        "00"
+        "ffffffff"
+        "01"
+        "2a00000000000000"
+        "00"
+        "00000000";
+
+    data_chunk data;
+    BOOST_REQUIRE(decode_base16(data, encoded));
+    return std::make_shared<message::transaction>(
+        message::transaction::factory(message::version::level::maximum,
+            data));
+}
+
+// Write one message from the peer socket, framed at the maximum version.
+template <class Message>
+static void write_message(asio::socket& peer, const Message& message,
+    const network::settings& configuration)
+{
+    const auto data = message::serialize(message::version::level::maximum,
+        message, configuration.identifier);
+    boost::asio::write(peer, boost::asio::buffer(data));
+}
+
+// Write one framed payload from the peer socket, without parsing it.
+static void write_raw(asio::socket& peer, const std::string& command,
+    const data_chunk& payload, const network::settings& configuration)
+{
+    const message::heading head(configuration.identifier, command,
+        static_cast<uint32_t>(payload.size()), bitcoin_checksum(payload));
+    boost::asio::write(peer, boost::asio::buffer(head.to_data()));
+    boost::asio::write(peer, boost::asio::buffer(payload));
+}
+
+typedef std::pair<message::heading, proxy::data_ptr> raw_message;
+
+// Start the proxy and capture the first payload passed through.
+static void receive_raw(proxy::ptr channel, std::promise<raw_message>& promise)
+{
+    channel->start([channel, &promise](const code&)
+    {
+        channel->subscribe_raw(
+            [&promise](const code& ec, const message::heading& head,
+                proxy::data_ptr payload)
+            {
+                if (!ec)
+                    promise.set_value({ head, payload });
+
+                return false;
+            });
+    });
+}
+
+// Start the proxy and capture the first transaction it receives.
+static void receive_transaction(proxy::ptr channel,
+    std::promise<transaction_const_ptr>& promise)
+{
+    channel->start([channel, &promise](const code&)
+    {
+        channel->subscribe<message::transaction>(
+            [&promise](const code& ec, transaction_const_ptr transaction)
+            {
+                if (!ec)
+                    promise.set_value(transaction);
+
+                return false;
+            });
+    });
+}
+
+// The first send is written immediately and the rest await its completion.
+static proxy::ptr send_mixed(threadpool& pool, asio::socket& peer,
+    const network::settings& configuration)
+{
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), configuration);
+    channel->start(ignore);
+    channel->send(message::transaction{}, ignore);
+    channel->send(message::headers{}, ignore);
+    channel->send(message::inventory{}, ignore);
+    channel->send(message::ping{ 42 }, ignore);
+    return channel;
+}
+
+BOOST_AUTO_TEST_CASE(proxy__classify__commands__expected_priorities)
+{
+    BOOST_REQUIRE(proxy::classify(message::ping::command) ==
+        send_priority::control);
+    BOOST_REQUIRE(proxy::classify(message::verack::command) ==
+        send_priority::control);
+    BOOST_REQUIRE(proxy::classify(message::inventory::command) ==
+        send_priority::announcement);
+    BOOST_REQUIRE(proxy::classify(message::get_data::command) ==
+        send_priority::announcement);
+    BOOST_REQUIRE(proxy::classify(message::block::command) ==
+        send_priority::bulk);
+    BOOST_REQUIRE(proxy::classify(message::transaction::command) ==
+        send_priority::bulk);
+}
+
+BOOST_AUTO_TEST_CASE(proxy__send__write_in_progress__queued_by_priority)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    const auto channel = send_mixed(pool, peer, network::settings());
+
+    using priority = send_priority;
+    BOOST_REQUIRE_EQUAL(channel->send_queue_depth(priority::control), 1u);
+    BOOST_REQUIRE_EQUAL(channel->send_queue_depth(priority::announcement), 1u);
+    BOOST_REQUIRE_EQUAL(channel->send_queue_depth(priority::bulk), 1u);
+    BOOST_REQUIRE_GT(channel->send_queue_bytes(priority::bulk), 0u);
+
+    pool.spawn(1, thread_priority::normal);
+    const auto commands = read_commands(peer, 4);
+    BOOST_REQUIRE_EQUAL(commands[0], message::transaction::command);
+    BOOST_REQUIRE_EQUAL(commands[1], message::ping::command);
+    BOOST_REQUIRE_EQUAL(commands[2], message::inventory::command);
+    BOOST_REQUIRE_EQUAL(commands[3], message::headers::command);
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(proxy__send__not_prioritized__submission_order)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    network::settings configuration;
+    configuration.prioritize_sends = false;
+    const auto channel = send_mixed(pool, peer, configuration);
+
+    pool.spawn(1, thread_priority::normal);
+    const auto commands = read_commands(peer, 4);
+    BOOST_REQUIRE_EQUAL(commands[0], message::transaction::command);
+    BOOST_REQUIRE_EQUAL(commands[1], message::headers::command);
+    BOOST_REQUIRE_EQUAL(commands[2], message::inventory::command);
+    BOOST_REQUIRE_EQUAL(commands[3], message::ping::command);
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(proxy__send__explicit_priority__overrides_command)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), network::settings());
+    channel->start(ignore);
+    channel->send(message::transaction{}, ignore);
+    channel->send(message::inventory{}, ignore);
+    channel->send(message::headers{}, send_priority::control, ignore);
+
+    pool.spawn(1, thread_priority::normal);
+    const auto commands = read_commands(peer, 3);
+    BOOST_REQUIRE_EQUAL(commands[1], message::headers::command);
+    BOOST_REQUIRE_EQUAL(commands[2], message::inventory::command);
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(proxy__receive__retain_payloads__payload_retained)
+{
+    threadpool pool(1);
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    network::settings configuration;
+    configuration.retain_payloads = true;
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), configuration);
+
+    std::promise<transaction_const_ptr> promise;
+    receive_transaction(channel, promise);
+    const auto sent = make_transaction();
+    write_message(peer, *sent, configuration);
+    const auto received = promise.get_future().get();
+
+    const auto payload = get_wire_payload(received);
+    BOOST_REQUIRE(payload != nullptr);
+    BOOST_REQUIRE(payload->data);
+    BOOST_REQUIRE(*payload->data ==
+        sent->to_data(message::version::level::maximum));
+    BOOST_REQUIRE(payload->hash == sent->hash());
+    BOOST_REQUIRE_EQUAL(payload->checksum(),
+        bitcoin_checksum(*payload->data));
+    BOOST_REQUIRE(received->hash() == sent->hash());
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(proxy__receive__default__payload_not_retained)
+{
+    threadpool pool(1);
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    const network::settings configuration;
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), configuration);
+
+    std::promise<transaction_const_ptr> promise;
+    receive_transaction(channel, promise);
+    write_message(peer, *make_transaction(), configuration);
+    const auto received = promise.get_future().get();
+    BOOST_REQUIRE(get_wire_payload(received) == nullptr);
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(proxy__send_raw__retained_payload__relayed_verbatim)
+{
+    threadpool pool(1);
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    network::settings configuration;
+    configuration.retain_payloads = true;
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), configuration);
+
+    std::promise<transaction_const_ptr> promise;
+    receive_transaction(channel, promise);
+    write_message(peer, *make_transaction(), configuration);
+    const auto received = promise.get_future().get();
+    const auto payload = get_wire_payload(received);
+    BOOST_REQUIRE(payload != nullptr);
+
+    channel->send_raw(message::transaction::command, payload->data,
+        payload->checksum(), ignore);
+
+    data_chunk relayed;
+    const auto head = read_message(peer, relayed);
+    BOOST_REQUIRE_EQUAL(head.command(), message::transaction::command);
+    BOOST_REQUIRE_EQUAL(head.checksum(), payload->checksum());
+    BOOST_REQUIRE(relayed == *payload->data);
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(proxy__set_pass_through__enable_disable__expected)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), network::settings());
+
+    BOOST_REQUIRE(!channel->pass_through(message::transaction::command));
+    channel->set_pass_through(message::transaction::command, true);
+    BOOST_REQUIRE(channel->pass_through(message::transaction::command));
+    BOOST_REQUIRE(!channel->pass_through(message::block::command));
+    channel->set_pass_through(message::transaction::command, false);
+    BOOST_REQUIRE(!channel->pass_through(message::transaction::command));
+}
+
+BOOST_AUTO_TEST_CASE(proxy__receive__pass_through__payload_not_parsed)
+{
+    threadpool pool(1);
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    const network::settings configuration;
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), configuration);
+    channel->set_pass_through(message::transaction::command, true);
+
+    // This is not a valid transaction, so parsing would stop the channel.
+    const data_chunk garbage{ 0xff, 0xff, 0xff };
+    std::promise<raw_message> promise;
+    receive_raw(channel, promise);
+    write_raw(peer, message::transaction::command, garbage, configuration);
+    const auto received = promise.get_future().get();
+
+    BOOST_REQUIRE_EQUAL(received.first.command(),
+        message::transaction::command);
+    BOOST_REQUIRE_EQUAL(received.first.checksum(), bitcoin_checksum(garbage));
+    BOOST_REQUIRE(*received.second == garbage);
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(proxy__send_raw__passed_through__forwarded_verbatim)
+{
+    threadpool pool(1);
+    boost::asio::io_service service;
+    asio::socket peer(service);
+    const network::settings configuration;
+    const auto channel = std::make_shared<test_proxy>(pool,
+        connect(pool, peer), configuration);
+    channel->set_pass_through("private", true);
+
+    const data_chunk data{ 0x01, 0x02, 0x03, 0x04 };
+    std::promise<raw_message> promise;
+    receive_raw(channel, promise);
+    write_raw(peer, "private", data, configuration);
+    const auto received = promise.get_future().get();
+
+    const auto& head = received.first;
+    channel->send_raw(head.command(), received.second, head.checksum(),
+        ignore);
+
+    data_chunk forwarded;
+    const auto relayed = read_message(peer, forwarded);
+    BOOST_REQUIRE_EQUAL(relayed.command(), "private");
+    BOOST_REQUIRE_EQUAL(relayed.checksum(), head.checksum());
+    BOOST_REQUIRE(forwarded == data);
+
+    channel->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(rolling_bloom_filter_tests)
+
+static hash_digest element(uint32_t index)
+{
+    return sha256_hash(to_little_endian(index));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_bloom_filter__contains__empty__false)
+{
+    const rolling_bloom_filter filter(100, 0.000001);
+    BOOST_REQUIRE(!filter.contains(element(0)));
+    BOOST_REQUIRE(!filter.contains(null_hash));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_bloom_filter__contains__inserted__true)
+{
+    rolling_bloom_filter filter(100, 0.000001);
+
+    for (uint32_t index = 0; index < 100; ++index)
+        filter.insert(element(index));
+
+    for (uint32_t index = 0; index < 100; ++index)
+        BOOST_REQUIRE(filter.contains(element(index)));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_bloom_filter__contains__recent_retained_oldest_forgotten)
+{
+    const uint32_t elements = 100;
+    rolling_bloom_filter filter(elements, 0.000001);
+
+    for (uint32_t index = 0; index < 3 * elements; ++index)
+    {
+        filter.insert(element(index));
+
+        // At least the most recent elements are always retained.
+        const auto first = index < elements ? 0 : index + 1 - elements;
+
+        for (auto recent = first; recent <= index; ++recent)
+            BOOST_REQUIRE(filter.contains(element(recent)));
+    }
+
+    // The first generation has been discarded.
+    size_t retained = 0;
+
+    for (uint32_t index = 0; index < elements; ++index)
+        if (filter.contains(element(index)))
+            ++retained;
+
+    BOOST_REQUIRE_EQUAL(retained, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(rolling_bloom_filter__contains__not_inserted__within_rate)
+{
+    const uint32_t elements = 1000;
+    rolling_bloom_filter filter(elements, 0.001);
+
+    for (uint32_t index = 0; index < elements; ++index)
+        filter.insert(element(index));
+
+    size_t positives = 0;
+    const uint32_t trials = 100000;
+
+    for (uint32_t index = elements; index < elements + trials; ++index)
+        if (filter.contains(element(index)))
+            ++positives;
+
+    // Expect about 100 at the configured rate, allow a wide margin.
+    BOOST_REQUIRE_LT(positives, 3u * trials / 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(rolling_bloom_filter__clear__inserted__false)
+{
+    rolling_bloom_filter filter(10, 0.000001);
+
+    for (uint32_t index = 0; index < 15; ++index)
+        filter.insert(element(index));
+
+    filter.clear();
+
+    for (uint32_t index = 0; index < 15; ++index)
+        BOOST_REQUIRE(!filter.contains(element(index)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <memory>
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(session_outbound_tests)
+
+// Exposes the active and standby channel bookkeeping.
+class test_session
+  : public session_outbound
+{
+public:
+    test_session(p2p& network)
+      : session_outbound(network, false)
+    {
+    }
+
+    using session_outbound::admit;
+    using session_outbound::promote;
+};
+
+static network::settings one_active_one_standby()
+{
+    network::settings configuration;
+    configuration.outbound_connections = 1;
+    configuration.standby_connections = 1;
+    return configuration;
+}
+
+// A channel connected to the peer socket over the loopback interface.
+// The channel is neither started nor run, only its identity is used.
+static channel::ptr make_channel(threadpool& pool, asio::socket& peer,
+    const network::settings& configuration)
+{
+    using namespace boost::asio::ip;
+    const tcp::endpoint loopback(address_v4::loopback(), 0);
+    asio::acceptor acceptor(peer.get_io_service(), loopback);
+    const auto socket = std::make_shared<bc::socket>(pool);
+    socket->get().connect(acceptor.local_endpoint());
+    acceptor.accept(peer);
+    return std::make_shared<channel>(pool, socket, configuration);
+}
+
+BOOST_AUTO_TEST_CASE(session_outbound__admit__below_target__active_then_standby)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    const auto configuration = one_active_one_standby();
+    p2p network(configuration);
+    const auto session = std::make_shared<test_session>(network);
+    asio::socket peer1(service);
+    asio::socket peer2(service);
+    const auto active = make_channel(pool, peer1, configuration);
+    const auto spare = make_channel(pool, peer2, configuration);
+
+    BOOST_REQUIRE(session->admit(active));
+    BOOST_REQUIRE(!session->admit(spare));
+
+    active->stop(error::channel_stopped);
+    spare->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(session_outbound__promote__active_stopped__spare_promoted)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    const auto configuration = one_active_one_standby();
+    p2p network(configuration);
+    const auto session = std::make_shared<test_session>(network);
+    asio::socket peer1(service);
+    asio::socket peer2(service);
+    const auto active = make_channel(pool, peer1, configuration);
+    const auto spare = make_channel(pool, peer2, configuration);
+    session->admit(active);
+    session->admit(spare);
+
+    BOOST_REQUIRE(session->promote(active) == spare);
+
+    // The promoted spare is active, so no further spare is available.
+    BOOST_REQUIRE(!session->promote(spare));
+
+    active->stop(error::channel_stopped);
+    spare->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+// The spare is promoted upon expiration, before the expiring channel stops,
+// so the stop of the expired channel promotes nothing further.
+BOOST_AUTO_TEST_CASE(session_outbound__promote__expired_then_stopped__make_before_break)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    const auto configuration = one_active_one_standby();
+    p2p network(configuration);
+    const auto session = std::make_shared<test_session>(network);
+    asio::socket peer1(service);
+    asio::socket peer2(service);
+    asio::socket peer3(service);
+    const auto expiring = make_channel(pool, peer1, configuration);
+    const auto spare = make_channel(pool, peer2, configuration);
+    const auto replacement = make_channel(pool, peer3, configuration);
+    session->admit(expiring);
+    session->admit(spare);
+
+    // Expiration.
+    BOOST_REQUIRE(session->promote(expiring) == spare);
+
+    // Stop of the expired channel.
+    BOOST_REQUIRE(!session->promote(expiring));
+
+    // The replacement connection becomes the spare, as the target is met.
+    BOOST_REQUIRE(!session->admit(replacement));
+    BOOST_REQUIRE(session->promote(spare) == replacement);
+
+    expiring->stop(error::channel_stopped);
+    spare->stop(error::channel_stopped);
+    replacement->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(session_outbound__promote__standby_stopped__none)
+{
+    threadpool pool;
+    boost::asio::io_service service;
+    const auto configuration = one_active_one_standby();
+    p2p network(configuration);
+    const auto session = std::make_shared<test_session>(network);
+    asio::socket peer1(service);
+    asio::socket peer2(service);
+    const auto active = make_channel(pool, peer1, configuration);
+    const auto spare = make_channel(pool, peer2, configuration);
+    session->admit(active);
+    session->admit(spare);
+
+    // The stopped spare is retired, so none remains to promote.
+    BOOST_REQUIRE(!session->promote(spare));
+    BOOST_REQUIRE(!session->promote(active));
+
+    active->stop(error::channel_stopped);
+    spare->stop(error::channel_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
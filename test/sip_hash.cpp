@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(sip_hash_tests)
+
+// Reference vectors of the SipHash-2-4 paper (key 00..0f, message 00..n-1).
+static const uint64_t key0 = 0x0706050403020100;
+static const uint64_t key1 = 0x0f0e0d0c0b0a0908;
+
+static data_chunk message_of(size_t size)
+{
+    data_chunk data(size);
+
+    for (size_t index = 0; index < size; ++index)
+        data[index] = static_cast<uint8_t>(index);
+
+    return data;
+}
+
+BOOST_AUTO_TEST_CASE(sip_hash__empty__expected)
+{
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(0)),
+        0x726fdb47dd0e0e31);
+}
+
+BOOST_AUTO_TEST_CASE(sip_hash__partial_word__expected)
+{
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(1)),
+        0x74f839c593dc67fd);
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(7)),
+        0xab0200f58b01d137);
+}
+
+BOOST_AUTO_TEST_CASE(sip_hash__whole_words__expected)
+{
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(8)),
+        0x93f5f5799a932462);
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(16)),
+        0x3f2acc7f57c29bdb);
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(32)),
+        0x7127512f72f27cce);
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(48)),
+        0xe612a3cb9ecba951);
+}
+
+BOOST_AUTO_TEST_CASE(sip_hash__words_and_remainder__expected)
+{
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(15)),
+        0xa129ca6149be45e5);
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(18)),
+        0x4bc1b3f0968dd39c);
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(27)),
+        0x2f2e6163076bcfad);
+    BOOST_REQUIRE_EQUAL(sip_hash(key0, key1, message_of(63)),
+        0x958a324ceb064572);
+}
+
+BOOST_AUTO_TEST_CASE(sip_hash__hash_digest__differs_by_key)
+{
+    const auto hash = sha256_hash(message_of(32));
+    BOOST_REQUIRE_NE(sip_hash(key0, key1, hash), sip_hash(key1, key0, hash));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,297 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(transaction_scheduler_tests)
+
+static const auto hash1 = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000001");
+static const auto hash2 = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000002");
+static const auto hash3 = hash_literal(
+    "0000000000000000000000000000000000000000000000000000000000000003");
+
+// Requests are sent on the calling thread, except upon timeout.
+class recorder
+{
+public:
+    transaction_scheduler::request_handler handler(uint64_t peer)
+    {
+        return [this, peer](const hash_list& hashes)
+        {
+            auto& list = requests[peer];
+            list.insert(list.end(), hashes.begin(), hashes.end());
+        };
+    }
+
+    size_t count(uint64_t peer)
+    {
+        return requests[peer].size();
+    }
+
+    std::map<uint64_t, hash_list> requests;
+};
+
+static network::settings configuration(uint32_t limit)
+{
+    network::settings value;
+    value.transaction_request_limit = limit;
+    value.transaction_request_timeout_seconds = 60;
+    return value;
+}
+
+class fixture
+{
+public:
+    fixture(uint32_t limit=100)
+      : pool(1),
+        scheduler(std::make_shared<transaction_scheduler>(pool,
+            configuration(limit)))
+    {
+        scheduler->start();
+    }
+
+    ~fixture()
+    {
+        scheduler->stop();
+        pool.shutdown();
+        pool.join();
+    }
+
+    threadpool pool;
+    transaction_scheduler::ptr scheduler;
+    recorder sent;
+};
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__announced__stopped__not_requested)
+{
+    threadpool pool(1);
+    const auto scheduler = std::make_shared<transaction_scheduler>(pool,
+        configuration(100));
+    recorder sent;
+    scheduler->connect(1, sent.handler(1));
+    scheduler->announced(1, { hash1 });
+    BOOST_REQUIRE_EQUAL(sent.count(1), 0u);
+    BOOST_REQUIRE_EQUAL(scheduler->announcements(), 0u);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__announced__unregistered_peer__not_requested)
+{
+    fixture test;
+    test.scheduler->announced(1, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__announced__two_peers__requested_once)
+{
+    fixture test;
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->connect(2, test.sent.handler(2));
+    test.scheduler->announced(1, { hash1 });
+    test.scheduler->announced(2, { hash1 });
+    test.scheduler->announced(1, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(2), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__announced__filtered__not_requested)
+{
+    fixture test;
+    test.scheduler->set_filter([](const hash_digest& hash)
+    {
+        return hash != hash2;
+    });
+
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->announced(1, { hash1, hash2, hash3 });
+    BOOST_REQUIRE(test.sent.requests[1] == hash_list({ hash1, hash3 }));
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__announced__over_limit__deferred_until_received)
+{
+    fixture test(2);
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->announced(1, { hash1, hash2, hash3 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 2u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 2u);
+
+    const auto first = test.sent.requests[1].front();
+    test.scheduler->received(1, first);
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 3u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 2u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__received__waiting_announcer__assigned_to_first_with_capacity)
+{
+    fixture test(1);
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->connect(2, test.sent.handler(2));
+    test.scheduler->announced(1, { hash1 });
+    test.scheduler->announced(2, { hash2 });
+
+    // Both announcers are at capacity.
+    test.scheduler->announced(1, { hash3 });
+    test.scheduler->announced(2, { hash3 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 1u);
+
+    // The second announcer gains capacity first.
+    test.scheduler->received(2, hash2);
+    BOOST_REQUIRE(test.sent.requests[2] == hash_list({ hash2, hash3 }));
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(2), 1u);
+
+    // The transaction no longer waits on the first announcer.
+    test.scheduler->received(1, hash1);
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__announced__peer_zero__requested_once)
+{
+    fixture test;
+    test.scheduler->connect(0, test.sent.handler(0));
+    test.scheduler->announced(0, { hash1 });
+    test.scheduler->announced(0, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(0), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(0), 1u);
+
+    test.scheduler->received(0, hash1);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(0), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__announced__received__ignored)
+{
+    fixture test;
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->connect(2, test.sent.handler(2));
+    test.scheduler->announced(1, { hash1 });
+    test.scheduler->received(1, hash1);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 0u);
+
+    test.scheduler->announced(2, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__not_found__other_announcer__reassigned)
+{
+    fixture test;
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->connect(2, test.sent.handler(2));
+    test.scheduler->announced(1, { hash1 });
+    test.scheduler->announced(2, { hash1 });
+    test.scheduler->not_found(1, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 0u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(2), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__not_found__all_announcers__excluded_and_dropped)
+{
+    fixture test;
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->connect(2, test.sent.handler(2));
+    test.scheduler->announced(1, { hash1 });
+    test.scheduler->announced(2, { hash1 });
+    test.scheduler->not_found(1, { hash1 });
+    test.scheduler->not_found(2, { hash1 });
+
+    // The first peer is not asked again.
+    BOOST_REQUIRE_EQUAL(test.sent.count(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 1u);
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__not_found__unrequested_peer__ignored)
+{
+    fixture test;
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->connect(2, test.sent.handler(2));
+    test.scheduler->announced(1, { hash1 });
+    test.scheduler->announced(2, { hash1 });
+    test.scheduler->not_found(2, { hash1 });
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 1u);
+    BOOST_REQUIRE_EQUAL(test.sent.count(2), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__disconnect__in_flight__reassigned)
+{
+    fixture test;
+    test.scheduler->connect(1, test.sent.handler(1));
+    test.scheduler->connect(2, test.sent.handler(2));
+    test.scheduler->announced(1, { hash1, hash2 });
+    test.scheduler->announced(2, { hash1 });
+    test.scheduler->disconnect(1);
+    BOOST_REQUIRE(test.sent.requests[2] == hash_list({ hash1 }));
+    BOOST_REQUIRE_EQUAL(test.scheduler->in_flight(1), 0u);
+
+    // The transaction announced only by the disconnected peer is dropped.
+    BOOST_REQUIRE_EQUAL(test.scheduler->announcements(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_scheduler__timeout__other_announcer__reassigned)
+{
+    threadpool pool(1);
+    auto settings = configuration(100);
+    settings.transaction_request_timeout_seconds = 1;
+    const auto scheduler = std::make_shared<transaction_scheduler>(pool,
+        settings);
+    scheduler->start();
+
+    std::promise<hash_list> promise;
+    scheduler->connect(1, [](const hash_list&) {});
+    scheduler->connect(2, [&promise](const hash_list& hashes)
+    {
+        promise.set_value(hashes);
+    });
+
+    scheduler->announced(1, { hash1 });
+    scheduler->announced(2, { hash1 });
+
+    auto future = promise.get_future();
+    BOOST_REQUIRE(future.wait_for(std::chrono::seconds(5)) ==
+        std::future_status::ready);
+    BOOST_REQUIRE(future.get() == hash_list({ hash1 }));
+    BOOST_REQUIRE_EQUAL(scheduler->in_flight(1), 0u);
+    BOOST_REQUIRE_EQUAL(scheduler->in_flight(2), 1u);
+
+    scheduler->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
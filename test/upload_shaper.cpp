@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/network.hpp>
+
+using namespace bc;
+using namespace bc::network;
+
+BOOST_AUTO_TEST_SUITE(upload_shaper_tests)
+
+static const auto timeout = std::chrono::seconds(5);
+
+static network::settings shaped(uint32_t global, uint32_t peer)
+{
+    network::settings configuration;
+    configuration.upload_kilobytes_per_second = global;
+    configuration.peer_upload_kilobytes_per_second = peer;
+    return configuration;
+}
+
+static std::function<void(const code&)> capture(std::promise<code>& promise)
+{
+    return [&promise](const code& ec)
+    {
+        promise.set_value(ec);
+    };
+}
+
+static bool ready(std::future<code>& future,
+    std::chrono::milliseconds wait=std::chrono::milliseconds(0))
+{
+    return future.wait_for(wait) == std::future_status::ready;
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__rate__defaults__configured)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(2, 3));
+    const auto flow = shaper->open();
+    BOOST_REQUIRE_EQUAL(shaper->rate(), 2u * 1024u);
+    BOOST_REQUIRE_EQUAL(shaper->rate(flow), 3u * 1024u);
+
+    shaper->set_rate(42);
+    shaper->set_rate(flow, 24);
+    BOOST_REQUIRE_EQUAL(shaper->rate(), 42u);
+    BOOST_REQUIRE_EQUAL(shaper->rate(flow), 24u);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__request__stopped__service_stopped)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(0, 0));
+    const auto flow = shaper->open();
+    std::promise<code> promise;
+    shaper->request(flow, 42, false, capture(promise));
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), error::service_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__request__closed_flow__channel_stopped)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(0, 0));
+    shaper->start();
+    const auto flow = shaper->open();
+    shaper->close(flow);
+    std::promise<code> promise;
+    shaper->request(flow, 42, false, capture(promise));
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), error::channel_stopped);
+    shaper->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__request__unlimited__granted_immediately)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(0, 0));
+    shaper->start();
+    const auto flow = shaper->open();
+
+    for (auto count = 0; count < 100; ++count)
+    {
+        std::promise<code> promise;
+        auto future = promise.get_future();
+        shaper->request(flow, 1000000, false, capture(promise));
+        BOOST_REQUIRE(ready(future));
+        BOOST_REQUIRE_EQUAL(future.get(), error::success);
+    }
+
+    shaper->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__request__overdrawn__delayed_until_refill)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(1, 0));
+    shaper->start();
+    const auto flow = shaper->open();
+
+    // The first write may overdraw the full bucket.
+    std::promise<code> first;
+    auto first_future = first.get_future();
+    shaper->request(flow, 2048, false, capture(first));
+    BOOST_REQUIRE(ready(first_future));
+    BOOST_REQUIRE_EQUAL(first_future.get(), error::success);
+
+    // The debt is repaid before the next write.
+    std::promise<code> second;
+    auto second_future = second.get_future();
+    shaper->request(flow, 1, false, capture(second));
+    BOOST_REQUIRE(!ready(second_future));
+    BOOST_REQUIRE(ready(second_future, timeout));
+    BOOST_REQUIRE_EQUAL(second_future.get(), error::success);
+
+    shaper->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__request__overdrawn_exempt__granted_immediately)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(1, 1));
+    shaper->start();
+    const auto flow = shaper->open();
+
+    std::promise<code> first;
+    auto first_future = first.get_future();
+    shaper->request(flow, 4096, false, capture(first));
+    BOOST_REQUIRE(ready(first_future));
+
+    std::promise<code> second;
+    auto second_future = second.get_future();
+    shaper->request(flow, 4096, true, capture(second));
+    BOOST_REQUIRE(ready(second_future));
+    BOOST_REQUIRE_EQUAL(second_future.get(), error::success);
+
+    shaper->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__request__overdrawn_peer__other_flow_granted)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(0, 1));
+    shaper->start();
+    const auto flow1 = shaper->open();
+    const auto flow2 = shaper->open();
+
+    std::promise<code> first;
+    auto first_future = first.get_future();
+    shaper->request(flow1, 4096, false, capture(first));
+    BOOST_REQUIRE(ready(first_future));
+
+    // The first flow is limited by its own bucket.
+    std::promise<code> second;
+    auto second_future = second.get_future();
+    shaper->request(flow1, 1, false, capture(second));
+    BOOST_REQUIRE(!ready(second_future));
+
+    // The second flow has its own bucket.
+    std::promise<code> third;
+    auto third_future = third.get_future();
+    shaper->request(flow2, 1, false, capture(third));
+    BOOST_REQUIRE(ready(third_future));
+    BOOST_REQUIRE_EQUAL(third_future.get(), error::success);
+
+    // Closing the flow fails its pending request.
+    shaper->close(flow1);
+    BOOST_REQUIRE(ready(second_future));
+    BOOST_REQUIRE_EQUAL(second_future.get(), error::channel_stopped);
+
+    shaper->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__stop__pending__service_stopped)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(1, 0));
+    shaper->start();
+    const auto flow = shaper->open();
+
+    std::promise<code> first;
+    shaper->request(flow, 4096, false, capture(first));
+
+    std::promise<code> second;
+    auto second_future = second.get_future();
+    shaper->request(flow, 1, false, capture(second));
+    BOOST_REQUIRE(!ready(second_future));
+
+    shaper->stop();
+    BOOST_REQUIRE(ready(second_future));
+    BOOST_REQUIRE_EQUAL(second_future.get(), error::service_stopped);
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__request__rate_below_refills__granted)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(0, 0));
+    shaper->start();
+    const auto flow = shaper->open();
+
+    // The empty bucket refills by at least one byte.
+    shaper->set_rate(5);
+    std::promise<code> promise;
+    auto future = promise.get_future();
+    shaper->request(flow, 1, false, capture(promise));
+    BOOST_REQUIRE(!ready(future));
+    BOOST_REQUIRE(ready(future, timeout));
+    BOOST_REQUIRE_EQUAL(future.get(), error::success);
+
+    shaper->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_CASE(upload_shaper__set_rate__unlimited__pending_granted)
+{
+    threadpool pool(1);
+    const auto shaper = std::make_shared<upload_shaper>(pool, shaped(1, 0));
+    shaper->start();
+    const auto flow = shaper->open();
+
+    std::promise<code> first;
+    shaper->request(flow, 1024 * 1024, false, capture(first));
+
+    std::promise<code> second;
+    auto second_future = second.get_future();
+    shaper->request(flow, 1, false, capture(second));
+    BOOST_REQUIRE(!ready(second_future));
+
+    // The pending request is granted on the next refill.
+    shaper->set_rate(0);
+    BOOST_REQUIRE(ready(second_future, timeout));
+    BOOST_REQUIRE_EQUAL(second_future.get(), error::success);
+
+    shaper->stop();
+    pool.shutdown();
+    pool.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()